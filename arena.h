@@ -0,0 +1,241 @@
+#ifndef _ARENA
+#define _ARENA
+
+// linear allocator made of chained blocks
+// allocations are only released together, either back to a mark or all at once with arena_reset
+// define ARENA_DEBUG to allocate blocks with a guard page after them (posix only) and to poison released memory
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE (64 * 1024 * 1024)  // blocks double in size up to this, bigger requests get a block of their own
+#define ARENA_DEFAULT_ALIGNMENT 16
+
+typedef struct Arena_Block {
+    struct Arena_Block* prev;
+    size_t size;  // usable bytes following the header
+    size_t used;
+} Arena_Block;
+
+typedef struct {
+    Arena_Block* current;
+    Arena_Block* spare;  // last released block, kept around so reset/push cycles do not go back to the system
+    size_t block_size;   // size of the next block
+    void* last;          // most recent allocation, the only one that can be resized in place
+} Arena;
+
+typedef struct {
+    Arena_Block* block;
+    size_t used;
+} Arena_Mark;
+
+Arena make_arena(size_t block_size);  // 0 for ARENA_DEFAULT_BLOCK_SIZE, nothing is allocated until the first push
+void* arena_push(Arena* arena, size_t size);  // returns NULL if the system is out of memory
+void* arena_push_aligned(Arena* arena, size_t size, size_t alignment);  // alignment must be a power of two
+void* arena_push_zero(Arena* arena, size_t size);
+void* arena_resize(Arena* arena, void* ptr, size_t old_size, size_t new_size);  // in place if ptr is the last allocation and it fits
+Arena_Mark arena_mark(Arena* arena);
+void arena_pop_to_mark(Arena* arena, Arena_Mark mark);
+void arena_reset(Arena* arena);
+void arena_free(Arena* arena);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _ARENA
+
+// outside the include guard, string_builder.h asks for the implementation after this header may have been included
+#if defined(ARENA_IMPLEMENTATION) && !defined(_ARENA_IMPLEMENTATION)
+#define _ARENA_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef ARENA_DEBUG
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif // ARENA_DEBUG
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+static size_t arena_align_up(size_t n, size_t alignment) {
+    return (n + alignment - 1) & ~(alignment - 1);
+}
+
+static Arena_Block* arena_new_block(size_t size) {
+#ifdef ARENA_DEBUG
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t total = arena_align_up(sizeof(Arena_Block) + size, page);
+#ifdef MAP_ANONYMOUS
+    char* mem = (char*)mmap(NULL, total + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#else
+    // strict iso modes (-std=c11) hide both names, a private mapping of /dev/zero gives the same zeroed pages
+    int zero = open("/dev/zero", O_RDWR);
+    if (zero < 0) return NULL;
+    char* mem = (char*)mmap(NULL, total + page, PROT_READ | PROT_WRITE, MAP_PRIVATE, zero, 0);
+    close(zero);
+#endif // MAP_ANONYMOUS
+    if (mem == MAP_FAILED) return NULL;
+    mprotect(mem + total, page, PROT_NONE);
+
+    Arena_Block* block = (Arena_Block*)mem;
+    block->size = total - sizeof(Arena_Block);
+#else
+    Arena_Block* block = (Arena_Block*)malloc(sizeof(Arena_Block) + size);
+    if (!block) return NULL;
+    block->size = size;
+#endif // ARENA_DEBUG
+
+    block->prev = NULL;
+    block->used = 0;
+    return block;
+}
+
+static void arena_delete_block(Arena_Block* block) {
+#ifdef ARENA_DEBUG
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    munmap(block, sizeof(Arena_Block) + block->size + page);
+#else
+    free(block);
+#endif // ARENA_DEBUG
+}
+
+static void arena_release_block(Arena* arena, Arena_Block* block) {
+    if (arena->spare && arena->spare->size >= block->size) {
+        arena_delete_block(block);
+        return;
+    }
+
+    if (arena->spare) arena_delete_block(arena->spare);
+    arena->spare = block;
+}
+
+Arena make_arena(size_t block_size) {
+    return (Arena) {
+        .current = NULL,
+        .spare = NULL,
+        .block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE,
+        .last = NULL,
+    };
+}
+
+void* arena_push_aligned(Arena* arena, size_t size, size_t alignment) {
+    Arena_Block* block = arena->current;
+    if (block) {
+        uintptr_t base = (uintptr_t)(block + 1);
+        size_t offset = arena_align_up(base + block->used, alignment) - base;
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            arena->last = (void*)(base + offset);
+            return arena->last;
+        }
+    }
+
+    size_t needed = size + alignment;
+    Arena_Block* next = NULL;
+    if (arena->spare && arena->spare->size >= needed) {
+        next = arena->spare;
+        arena->spare = NULL;
+        next->used = 0;
+    }
+    else {
+        size_t block_size = arena->block_size > needed ? arena->block_size : needed;
+        next = arena_new_block(block_size);
+        if (!next) {
+            fprintf(stderr, "Arena failed to allocate a block of %zu bytes\n", block_size);
+            return NULL;
+        }
+
+        if (arena->block_size < ARENA_MAX_BLOCK_SIZE) {
+            arena->block_size *= 2;
+        }
+    }
+
+    next->prev = block;
+    arena->current = next;
+
+    uintptr_t base = (uintptr_t)(next + 1);
+    size_t offset = arena_align_up(base, alignment) - base;
+    next->used = offset + size;
+    arena->last = (void*)(base + offset);
+    return arena->last;
+}
+
+void* arena_push(Arena* arena, size_t size) {
+    return arena_push_aligned(arena, size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+void* arena_push_zero(Arena* arena, size_t size) {
+    void* mem = arena_push(arena, size);
+    if (mem) memset(mem, 0, size);
+    return mem;
+}
+
+void* arena_resize(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    Arena_Block* block = arena->current;
+    if (ptr && ptr == arena->last) {
+        size_t offset = (uintptr_t)ptr - (uintptr_t)(block + 1);
+        if (offset + new_size <= block->size) {
+            block->used = offset + new_size;
+            return ptr;
+        }
+    }
+
+    void* mem = arena_push(arena, new_size);
+    if (mem && ptr) memcpy(mem, ptr, old_size < new_size ? old_size : new_size);
+    return mem;
+}
+
+Arena_Mark arena_mark(Arena* arena) {
+    return (Arena_Mark) {
+        .block = arena->current,
+        .used = arena->current ? arena->current->used : 0,
+    };
+}
+
+void arena_pop_to_mark(Arena* arena, Arena_Mark mark) {
+    while (arena->current && arena->current != mark.block) {
+        Arena_Block* prev = arena->current->prev;
+        arena_release_block(arena, arena->current);
+        arena->current = prev;
+    }
+
+    if (arena->current) {
+#ifdef ARENA_DEBUG
+        memset((char*)(arena->current + 1) + mark.used, 0xcd, arena->current->used - mark.used);
+#endif // ARENA_DEBUG
+        arena->current->used = mark.used;
+    }
+    arena->last = NULL;
+}
+
+void arena_reset(Arena* arena) {
+    arena_pop_to_mark(arena, (Arena_Mark){.block = NULL, .used = 0});
+}
+
+void arena_free(Arena* arena) {
+    arena_reset(arena);
+    if (arena->spare) arena_delete_block(arena->spare);
+    arena->spare = NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // ARENA_IMPLEMENTATION
@@ -0,0 +1,125 @@
+// hash_string64 against the polynomial hash_string had before hash.h, over 4096 distinct keys per length
+// also checks hash_bytes against xxh64 reference values
+// cc -O2 -I.. -o hash_bench hash_bench.c -lm && ./hash_bench
+
+#define STRING_BUILDER_IMPLEMENTATION
+#define HASH_IMPLEMENTATION
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define KEY_COUNT 4096
+
+// the old hash_string, unsigned so the overflow is defined
+static unsigned int old_hash_string(const String* string) {
+    unsigned int result = 0;
+    unsigned int pow = 1;
+
+    for (int i = string->size - 1; i > 0; i--, pow *= 31) {
+        result += string->data[i] * pow;
+    }
+
+    result += string->data[0] * pow;
+
+    return result;
+}
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bool check_reference(void) {
+    unsigned char bytes[100];
+    for (int i = 0; i < 100; i++) bytes[i] = (unsigned char)i;
+
+    struct {
+        const void* data;
+        size_t size;
+        uint64_t seed;
+        uint64_t expected;
+    } cases[] = {
+        {"", 0, 0, 0xef46db3751d8e999ull},
+        {"abc", 3, 0, 0x44bc2cf5ad770999ull},
+        {"abc", 3, 1, 0xbea9ca8199328908ull},
+        {bytes, sizeof(bytes), 0x9E3779B185EBCA87ull, 0x00278bda0ee3f586ull},
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint64_t one_shot = hash_bytes(cases[i].data, cases[i].size, cases[i].seed);
+
+        Hash_State state;
+        hash_init(&state, cases[i].seed);
+        for (size_t done = 0; done < cases[i].size; done += 7) {
+            size_t chunk = cases[i].size - done < 7 ? cases[i].size - done : 7;
+            hash_update(&state, (const char*)cases[i].data + done, chunk);
+        }
+        uint64_t streamed = hash_final(&state);
+
+        if (one_shot != cases[i].expected || streamed != cases[i].expected) {
+            fprintf(stderr, "case %zu: %016llx one shot, %016llx streamed, expected %016llx\n", i,
+                    (unsigned long long)one_shot, (unsigned long long)streamed, (unsigned long long)cases[i].expected);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void bench_length(int length) {
+    char* data = malloc((size_t)KEY_COUNT * length);
+    String* keys = malloc(KEY_COUNT * sizeof(String));
+    srand(length);
+    for (int i = 0; i < KEY_COUNT; i++) {
+        for (int j = 0; j < length; j++) data[(size_t)i * length + j] = (char)('a' + rand() % 26);
+        keys[i] = (String){.data = data + (size_t)i * length, .size = length};
+    }
+
+    int rounds = (int)(64 * 1024 * 1024 / ((size_t)KEY_COUNT * (length + 16))) + 1;
+    double best_old = 1e9, best_new = 1e9;
+    volatile uint64_t sink = 0;
+
+    for (int attempt = 0; attempt < 5; attempt++) {
+        double start = now_seconds();
+        unsigned int old_sum = 0;
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < KEY_COUNT; i++) old_sum += old_hash_string(&keys[i]);
+        }
+        double old_time = now_seconds() - start;
+        sink += old_sum;
+
+        start = now_seconds();
+        uint64_t new_sum = 0;
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < KEY_COUNT; i++) new_sum += hash_string64(keys[i], 0);
+        }
+        double new_time = now_seconds() - start;
+        sink += new_sum;
+
+        if (old_time < best_old) best_old = old_time;
+        if (new_time < best_new) best_new = new_time;
+    }
+    (void)sink;
+
+    double hashes = (double)rounds * KEY_COUNT;
+    printf("len %5d: old %8.1f ns (%5.2f GB/s), new %8.1f ns (%5.2f GB/s)\n", length,
+           best_old / hashes * 1e9, hashes * length / best_old * 1e-9,
+           best_new / hashes * 1e9, hashes * length / best_new * 1e-9);
+
+    free(keys);
+    free(data);
+}
+
+int main(void) {
+    if (!check_reference()) {
+        printf("failed\n");
+        return 1;
+    }
+
+    int lengths[] = {8, 16, 64, 512, 4096};
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) bench_length(lengths[i]);
+    return 0;
+}
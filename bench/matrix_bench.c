@@ -0,0 +1,131 @@
+// the mat3_multiply and mat4_multiply kernels against each other and a plain triple loop
+// chained products measure the latency of one multiply, independent ones how many fit in flight
+// cc -O2 -I.. -o matrix_bench matrix_bench.c -lm && ./matrix_bench
+
+#define LINEAR_MATH_IMPLEMENTATION
+#include "linear_math.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define MULTIPLIES (4 * 1024 * 1024)
+#define MATRIX_COUNT 256  // chained through a small table so the loads stay in cache and the compiler cannot fold them
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// the unpadded loop mat3_multiply was before the kernels
+static void mat3_multiply_loop(mat3* dest, mat3* m, mat3* n) {
+    float d[9];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            float accum = 0;
+            for (int k = 0; k < 3; k++) accum += m->m[INDEX(i, k)] * n->m[INDEX(k, j)];
+            d[i * 3 + j] = accum;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) dest->m[INDEX(i, j)] = d[i * 3 + j];
+    }
+}
+
+static void mat4_multiply_loop(mat4* dest, mat4* m, mat4* n) {
+    float d[16];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            float accum = 0;
+            for (int k = 0; k < 4; k++) accum += m->m[INDEX(i, k)] * n->m[INDEX(k, j)];
+            d[INDEX(i, j)] = accum;
+        }
+    }
+    memcpy(dest->m, d, sizeof(d));
+}
+
+static mat3 mat3_table[MATRIX_COUNT];
+static mat4 mat4_table[MATRIX_COUNT];
+static mat3 mat3_out[MATRIX_COUNT];
+static mat4 mat4_out[MATRIX_COUNT];
+
+typedef void (*Mat3_Multiply)(mat3*, mat3*, mat3*);
+typedef void (*Mat4_Multiply)(mat4*, mat4*, mat4*);
+
+static double best_of_5(void (*run)(void*), void* kernel) {
+    double best = 1e9;
+    for (int attempt = 0; attempt < 5; attempt++) {
+        double start = now_seconds();
+        run(kernel);
+        double t = now_seconds() - start;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static void run_mat3(void* kernel) {
+    Mat3_Multiply multiply = (Mat3_Multiply)kernel;
+    mat3 acc = mat3_identity();
+    for (int i = 0; i < MULTIPLIES; i++) {
+        multiply(&acc, &acc, &mat3_table[i & (MATRIX_COUNT - 1)]);
+    }
+    volatile float sink = acc.m00;
+    (void)sink;
+}
+
+static void run_mat3_independent(void* kernel) {
+    Mat3_Multiply multiply = (Mat3_Multiply)kernel;
+    for (int i = 0; i < MULTIPLIES; i++) {
+        int j = i & (MATRIX_COUNT - 1);
+        multiply(&mat3_out[j], &mat3_table[j], &mat3_table[(j + 1) & (MATRIX_COUNT - 1)]);
+    }
+}
+
+static void run_mat4_independent(void* kernel) {
+    Mat4_Multiply multiply = (Mat4_Multiply)kernel;
+    for (int i = 0; i < MULTIPLIES; i++) {
+        int j = i & (MATRIX_COUNT - 1);
+        multiply(&mat4_out[j], &mat4_table[j], &mat4_table[(j + 1) & (MATRIX_COUNT - 1)]);
+    }
+}
+
+static void run_mat4(void* kernel) {
+    Mat4_Multiply multiply = (Mat4_Multiply)kernel;
+    mat4 acc;
+    memcpy(&acc, &mat4_table[0], sizeof(acc));
+    for (int i = 0; i < MULTIPLIES; i++) {
+        multiply(&acc, &acc, &mat4_table[i & (MATRIX_COUNT - 1)]);
+    }
+    volatile float sink = acc.m[0];
+    (void)sink;
+}
+
+static void report(const char* name, void (*chained)(void*), void (*independent)(void*), void* kernel) {
+    printf("%s %7.1f ms %7.1f ms\n", name, best_of_5(chained, kernel) * 1e3, best_of_5(independent, kernel) * 1e3);
+}
+
+int main(void) {
+    // rotations keep the chained products bounded
+    for (int i = 0; i < MATRIX_COUNT; i++) {
+        mat3_axis_rotation_matrix(&mat3_table[i], 0.001f * i, (Axis)(i % 3));
+        mat4_rotation_matrix(&mat4_table[i], 0.001f * i, (Axis)(i % 3));
+    }
+
+    printf("%d multiplies, best of 5, chained / independent\n", MULTIPLIES);
+    report("mat3 loop    ", run_mat3, run_mat3_independent, (void*)mat3_multiply_loop);
+    report("mat3 scalar  ", run_mat3, run_mat3_independent, (void*)mat3_multiply_scalar);
+#ifdef LINEAR_MATH_SIMD_X86
+    report("mat3 sse2    ", run_mat3, run_mat3_independent, (void*)mat3_multiply_sse2);
+    if (linear_math_cpu() >= 3) report("mat3 fma     ", run_mat3, run_mat3_independent, (void*)mat3_multiply_fma);
+#endif
+    report("mat3_multiply", run_mat3, run_mat3_independent, (void*)mat3_multiply);
+
+    report("mat4 loop    ", run_mat4, run_mat4_independent, (void*)mat4_multiply_loop);
+    report("mat4 scalar  ", run_mat4, run_mat4_independent, (void*)mat4_multiply_scalar);
+#ifdef LINEAR_MATH_SIMD_X86
+    report("mat4 sse2    ", run_mat4, run_mat4_independent, (void*)mat4_multiply_sse2);
+    if (linear_math_cpu() >= 3) report("mat4 fma     ", run_mat4, run_mat4_independent, (void*)mat4_multiply_fma);
+#endif
+    report("mat4_multiply", run_mat4, run_mat4_independent, (void*)mat4_multiply);
+    return 0;
+}
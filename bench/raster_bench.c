@@ -0,0 +1,161 @@
+// raster.h against naive per pixel loops on a 4k canvas
+// cc -O2 -I.. -o raster_bench raster_bench.c -lpthread -lm && ./raster_bench
+// build with -DRASTER_NO_SIMD to time the scalar span kernels instead
+
+#define UTILITY_IMPLEMENTATION
+#include "utility.h"
+#include "raster.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WIDTH 3840
+#define HEIGHT 2160
+#define SMALL_TRIANGLES 100000
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void naive_clear(Canvas canvas, Color color) {
+    for (int y = 0; y < canvas.height; y++) {
+        for (int x = 0; x < canvas.width; x++) {
+            canvas.canvas[(size_t)y * canvas.width + x] = color_to_rgb(color);
+        }
+    }
+}
+
+static float naive_edge(vec2 a, vec2 b, float x, float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+// every pixel of the bounding box tests the three edges and mixes the colours with its barycentric weights
+static void naive_triangle(Canvas canvas, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc) {
+    float area = naive_edge(a, b, c.x, c.y);
+    if (area == 0) return;
+
+    int x0 = (int)fmaxf(0, floorf(fminf(a.x, fminf(b.x, c.x))));
+    int y0 = (int)fmaxf(0, floorf(fminf(a.y, fminf(b.y, c.y))));
+    int x1 = (int)fminf(canvas.width, ceilf(fmaxf(a.x, fmaxf(b.x, c.x))) + 1);
+    int y1 = (int)fminf(canvas.height, ceilf(fmaxf(a.y, fmaxf(b.y, c.y))) + 1);
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            float px = x + 0.5f, py = y + 0.5f;
+            float wa = naive_edge(b, c, px, py) / area;
+            float wb = naive_edge(c, a, px, py) / area;
+            float wc = naive_edge(a, b, px, py) / area;
+            if (wa < 0 || wb < 0 || wc < 0) continue;
+
+            canvas.canvas[(size_t)y * canvas.width + x] = (rgb_t){
+                .r = (unsigned char)(wa * ca.r + wb * cb.r + wc * cc.r + 0.5f),
+                .g = (unsigned char)(wa * ca.g + wb * cb.g + wc * cc.g + 0.5f),
+                .b = (unsigned char)(wa * ca.b + wb * cb.b + wc * cc.b + 0.5f),
+            };
+        }
+    }
+}
+
+static void naive_blit(Canvas canvas, ivec2 pos, const rgba_t* pixels, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int cx = pos.x + x, cy = pos.y + y;
+            if (cx < 0 || cy < 0 || cx >= canvas.width || cy >= canvas.height) continue;
+
+            rgba_t s = pixels[(size_t)y * width + x];
+            rgb_t* d = &canvas.canvas[(size_t)cy * canvas.width + cx];
+            d->r = (unsigned char)((s.r * s.a + d->r * (255 - s.a) + 127) / 255);
+            d->g = (unsigned char)((s.g * s.a + d->g * (255 - s.a) + 127) / 255);
+            d->b = (unsigned char)((s.b * s.a + d->b * (255 - s.a) + 127) / 255);
+        }
+    }
+}
+
+typedef struct {
+    Canvas canvas;
+    rgba_t* image;
+    vec2* points;  // three per small triangle
+} Bench;
+
+static double run(const Bench* bench, bool naive, int which) {
+    Canvas canvas = bench->canvas;
+    double start = now_seconds();
+    switch (which) {
+    case 0:
+        if (naive) naive_clear(canvas, BLUE);
+        else canvas_clear(canvas, BLUE);
+        break;
+    case 1: {
+        vec2 a = {0, 0}, b = {WIDTH, 0}, c = {WIDTH / 2.0f, HEIGHT};
+        if (naive) naive_triangle(canvas, a, b, c, RED, GREEN, BLUE);
+        else canvas_fill_triangle(canvas, a, b, c, RED, GREEN, BLUE);
+        break;
+    }
+    case 2:
+        if (naive) naive_blit(canvas, (ivec2){0, 0}, bench->image, WIDTH, HEIGHT);
+        else canvas_blit(canvas, (ivec2){0, 0}, bench->image, WIDTH, HEIGHT);
+        break;
+    case 3:
+        for (int i = 0; i < SMALL_TRIANGLES; i++) {
+            const vec2* p = &bench->points[i * 3];
+            if (naive) naive_triangle(canvas, p[0], p[1], p[2], RED, GREEN, BLUE);
+            else canvas_fill_triangle(canvas, p[0], p[1], p[2], RED, GREEN, BLUE);
+        }
+        break;
+    }
+    return now_seconds() - start;
+}
+
+int main(void) {
+    Bench bench = {
+        .canvas = make_canvas(WIDTH, HEIGHT),
+        .image = malloc((size_t)WIDTH * HEIGHT * sizeof(rgba_t)),
+        .points = malloc(SMALL_TRIANGLES * 3 * sizeof(vec2)),
+    };
+
+    srand(1);
+    for (size_t i = 0; i < (size_t)WIDTH * HEIGHT; i++) {
+        bench.image[i] = (rgba_t){.r = rand() & 0xff, .g = rand() & 0xff, .b = rand() & 0xff, .a = rand() & 0xff};
+    }
+    for (int i = 0; i < SMALL_TRIANGLES; i++) {
+        float x = (float)(rand() % (WIDTH - 30)), y = (float)(rand() % (HEIGHT - 25));
+        bench.points[i * 3 + 0] = (vec2){x, y};
+        bench.points[i * 3 + 1] = (vec2){x + 30, y + 5};
+        bench.points[i * 3 + 2] = (vec2){x + 10, y + 25};
+    }
+
+    // clear and blit round the same way in both versions
+    size_t size = (size_t)WIDTH * HEIGHT * sizeof(rgb_t);
+    rgb_t* expected = malloc(size);
+    naive_clear(bench.canvas, BLUE);
+    naive_blit(bench.canvas, (ivec2){0, 0}, bench.image, WIDTH, HEIGHT);
+    memcpy(expected, bench.canvas.canvas, size);
+    canvas_clear(bench.canvas, BLUE);
+    canvas_blit(bench.canvas, (ivec2){0, 0}, bench.image, WIDTH, HEIGHT);
+    if (memcmp(expected, bench.canvas.canvas, size) != 0) {
+        printf("canvas_clear and canvas_blit differ from the naive loops\n");
+        return 1;
+    }
+    free(expected);
+
+    const char* names[] = {"clear", "4k gradient triangle", "full screen blit", "100k 30x25 px triangles"};
+    for (int which = 0; which < 4; which++) {
+        double best_naive = 1e9, best_raster = 1e9;
+        for (int attempt = 0; attempt < 5; attempt++) {
+            double t = run(&bench, true, which);
+            if (t < best_naive) best_naive = t;
+            t = run(&bench, false, which);
+            if (t < best_raster) best_raster = t;
+        }
+        printf("%-24s naive %8.2f ms, raster.h %8.2f ms\n", names[which], best_naive * 1e3, best_raster * 1e3);
+    }
+
+    free(bench.points);
+    free(bench.image);
+    free(bench.canvas.canvas);
+    return 0;
+}
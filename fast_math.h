@@ -0,0 +1,310 @@
+#ifndef _FAST_MATH
+#define _FAST_MATH
+
+// float math over arrays, for the hundreds of thousands of values a frame computes
+// sincos goes 8 values per avx2 + fma iteration, the normalizes 4 vectors per sse iteration with rsqrt,
+// lerp and smoothstep 8 values per avx iteration, picked at runtime like in raster.h (define FAST_MATH_NO_SIMD to always use the scalar loops)
+// the maximum errors below were measured against double precision on every path
+// destinations can be the same arrays as the sources
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+
+#include "utility.h"
+
+// |x| <= 8192: sin and cos within 1e-7 absolute, values outside (and nan, inf) go through sinf and cosf
+void sincos_array(float* sines, float* cosines, const float* x, int count);
+
+// refine = false: the rsqrt estimate, relative error of the length of the result below 3.7e-4
+// refine = true: one newton step on it, below 4e-7
+// a zero vector gives nans, like vec2_normalize
+void vec2_normalize_array(vec2* dst, const vec2* src, int count, bool refine);
+void vec3_normalize_array(vec3* dst, const vec3* src, int count, bool refine);
+
+// (1 - t) * s + t * e, exact at t = 0 and t = 1, within 1.5 * FLT_EPSILON * max(|s|, |e|) for t in between
+// (half an epsilon for each rounding of 1 - t, the two products and the sum, to first order)
+void lerp_array(float* dst, const float* s, const float* e, float t, int count);
+// x clamped to [0, 1] then x * x * (3 - 2 * x), within 1e-7 absolute, the same values as smoothstep
+void smoothstep_array(float* dst, const float* x, int count);
+
+#ifdef FAST_MATH_IMPLEMENTATION
+
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(FAST_MATH_NO_SIMD)
+#define FAST_MATH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// x = q * pi/2 + r with |r| <= pi/4, pi/2 split in three so q * FAST_MATH_PIO2_1 is exact for |q| < 2^16
+#define FAST_MATH_SINCOS_LIMIT 8192.0f
+#define FAST_MATH_2_OVER_PI 0.636619772367581343f
+#define FAST_MATH_PIO2_1 1.5703125f
+#define FAST_MATH_PIO2_2 4.837512969970703125e-4f
+#define FAST_MATH_PIO2_3 7.54978995489188216e-8f
+
+// minimax polynomials on [-pi/4, pi/4] from cephes
+#define FAST_MATH_SIN_1 -1.6666654611e-1f
+#define FAST_MATH_SIN_2 8.3321608736e-3f
+#define FAST_MATH_SIN_3 -1.9515295891e-4f
+#define FAST_MATH_COS_1 4.166664568298827e-2f
+#define FAST_MATH_COS_2 -1.388731625493765e-3f
+#define FAST_MATH_COS_3 2.443315711809948e-5f
+
+typedef void (*Fast_Math_Sincos)(float* sines, float* cosines, const float* x, int count);
+typedef void (*Fast_Math_Normalize2)(vec2* dst, const vec2* src, int count, bool refine);
+typedef void (*Fast_Math_Normalize3)(vec3* dst, const vec3* src, int count, bool refine);
+typedef void (*Fast_Math_Lerp)(float* dst, const float* s, const float* e, float t, int count);
+typedef void (*Fast_Math_Smoothstep)(float* dst, const float* x, int count);
+
+static void sincos_array_scalar(float* sines, float* cosines, const float* x, int count) {
+    for (int i = 0; i < count; i++) {
+        float v = x[i];
+        if (!(fabsf(v) <= FAST_MATH_SINCOS_LIMIT)) {
+            sines[i] = sinf(v);
+            cosines[i] = cosf(v);
+            continue;
+        }
+
+        float q = rintf(v * FAST_MATH_2_OVER_PI);
+        float r = ((v - q * FAST_MATH_PIO2_1) - q * FAST_MATH_PIO2_2) - q * FAST_MATH_PIO2_3;
+        float r2 = r * r;
+        float s = r + r * r2 * (FAST_MATH_SIN_1 + r2 * (FAST_MATH_SIN_2 + r2 * FAST_MATH_SIN_3));
+        float c = 1 - 0.5f * r2 + r2 * r2 * (FAST_MATH_COS_1 + r2 * (FAST_MATH_COS_2 + r2 * FAST_MATH_COS_3));
+
+        // sin(q * pi/2 + r) goes sin r, cos r, -sin r, -cos r as q goes around
+        int quadrant = (int)q;
+        float sine = quadrant & 1 ? c : s;
+        float cosine = quadrant & 1 ? s : c;
+        sines[i] = quadrant & 2 ? -sine : sine;
+        cosines[i] = (quadrant + 1) & 2 ? -cosine : cosine;
+    }
+}
+
+static void vec2_normalize_array_scalar(vec2* dst, const vec2* src, int count, bool refine) {
+    (void)refine;  // the exact one is both
+    for (int i = 0; i < count; i++) {
+        float r = 1 / sqrtf(src[i].x * src[i].x + src[i].y * src[i].y);
+        dst[i] = (vec2){src[i].x * r, src[i].y * r};
+    }
+}
+
+static void vec3_normalize_array_scalar(vec3* dst, const vec3* src, int count, bool refine) {
+    (void)refine;
+    for (int i = 0; i < count; i++) {
+        float r = 1 / sqrtf(src[i].x * src[i].x + src[i].y * src[i].y + src[i].z * src[i].z);
+        dst[i] = (vec3){src[i].x * r, src[i].y * r, src[i].z * r};
+    }
+}
+
+static void lerp_array_scalar(float* dst, const float* s, const float* e, float t, int count) {
+    float u = 1 - t;
+    for (int i = 0; i < count; i++) {
+        dst[i] = u * s[i] + t * e[i];
+    }
+}
+
+static void smoothstep_array_scalar(float* dst, const float* x, int count) {
+    for (int i = 0; i < count; i++) {
+        float v = CLAMP(x[i], 0.0f, 1.0f);
+        dst[i] = (v * v) * (3 - 2 * v);
+    }
+}
+
+#ifdef FAST_MATH_SIMD_X86
+
+__attribute__((target("avx2,fma")))
+static void sincos_array_avx2(float* sines, float* cosines, const float* x, int count) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        // out of range or nan, the whole block goes through libm
+        __m256 out = _mm256_cmp_ps(_mm256_andnot_ps(sign, v), _mm256_set1_ps(FAST_MATH_SINCOS_LIMIT), _CMP_NLE_UQ);
+        if (_mm256_movemask_ps(out)) {
+            _mm256_zeroupper();
+            sincos_array_scalar(sines + i, cosines + i, x + i, 8);
+            continue;
+        }
+
+        __m256 q = _mm256_round_ps(_mm256_mul_ps(v, _mm256_set1_ps(FAST_MATH_2_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(q, _mm256_set1_ps(FAST_MATH_PIO2_1), v);
+        r = _mm256_fnmadd_ps(q, _mm256_set1_ps(FAST_MATH_PIO2_2), r);
+        r = _mm256_fnmadd_ps(q, _mm256_set1_ps(FAST_MATH_PIO2_3), r);
+        __m256 r2 = _mm256_mul_ps(r, r);
+
+        __m256 s = _mm256_fmadd_ps(r2, _mm256_set1_ps(FAST_MATH_SIN_3), _mm256_set1_ps(FAST_MATH_SIN_2));
+        s = _mm256_fmadd_ps(r2, s, _mm256_set1_ps(FAST_MATH_SIN_1));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(r, r2), s, r);
+        __m256 c = _mm256_fmadd_ps(r2, _mm256_set1_ps(FAST_MATH_COS_3), _mm256_set1_ps(FAST_MATH_COS_2));
+        c = _mm256_fmadd_ps(r2, c, _mm256_set1_ps(FAST_MATH_COS_1));
+        c = _mm256_fmadd_ps(_mm256_mul_ps(r2, r2), c, _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, _mm256_set1_ps(1)));
+
+        __m256i quadrant = _mm256_cvtps_epi32(q);
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+        __m256 sine = _mm256_blendv_ps(s, c, swap);
+        __m256 cosine = _mm256_blendv_ps(c, s, swap);
+        // bit 1 of the quadrant moved to the sign bit
+        __m256 sine_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+        __m256 cosine_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+        _mm256_storeu_ps(sines + i, _mm256_xor_ps(sine, sine_sign));
+        _mm256_storeu_ps(cosines + i, _mm256_xor_ps(cosine, cosine_sign));
+    }
+    _mm256_zeroupper();
+    sincos_array_scalar(sines + i, cosines + i, x + i, count - i);
+}
+
+// rsqrt is good to 12 bits, a newton step r * (1.5 - 0.5 * d * r * r) brings it to about 22
+__attribute__((target("sse2")))
+static inline __m128 fast_math_rsqrt(__m128 d, bool refine) {
+    __m128 r = _mm_rsqrt_ps(d);
+    if (refine) {
+        __m128 half_d = _mm_mul_ps(d, _mm_set1_ps(0.5f));
+        r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(half_d, r), r)));
+    }
+    return r;
+}
+
+__attribute__((target("sse2")))
+static void vec2_normalize_array_sse2(vec2* dst, const vec2* src, int count, bool refine) {
+    const float* in = (const float*)src;
+    float* out = (float*)dst;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // two vectors per register, the squared length ends up in both of their lanes
+        __m128 a = _mm_loadu_ps(in + i * 2), b = _mm_loadu_ps(in + i * 2 + 4);
+        __m128 a2 = _mm_mul_ps(a, a), b2 = _mm_mul_ps(b, b);
+        a2 = _mm_add_ps(a2, _mm_shuffle_ps(a2, a2, _MM_SHUFFLE(2, 3, 0, 1)));
+        b2 = _mm_add_ps(b2, _mm_shuffle_ps(b2, b2, _MM_SHUFFLE(2, 3, 0, 1)));
+        _mm_storeu_ps(out + i * 2, _mm_mul_ps(a, fast_math_rsqrt(a2, refine)));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_mul_ps(b, fast_math_rsqrt(b2, refine)));
+    }
+    vec2_normalize_array_scalar(dst + i, src + i, count - i, refine);
+}
+
+__attribute__((target("sse2")))
+static void vec3_normalize_array_sse2(vec3* dst, const vec3* src, int count, bool refine) {
+    const float* in = (const float*)src;
+    float* out = (float*)dst;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(in + i * 3);      // x0 y0 z0 x1
+        __m128 b = _mm_loadu_ps(in + i * 3 + 4);  // y1 z1 x2 y2
+        __m128 c = _mm_loadu_ps(in + i * 3 + 8);  // z2 x3 y3 z3
+        // the coordinates apart as in vec3_soa_from_aos
+        __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 r = fast_math_rsqrt(d, refine);
+        // each scale spread over the lanes its vector has in the original layout
+        _mm_storeu_ps(out + i * 3, _mm_mul_ps(a, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 0, 0))));
+        _mm_storeu_ps(out + i * 3 + 4, _mm_mul_ps(b, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 1, 1))));
+        _mm_storeu_ps(out + i * 3 + 8, _mm_mul_ps(c, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 2))));
+    }
+    vec3_normalize_array_scalar(dst + i, src + i, count - i, refine);
+}
+
+// separate mul and add so the results are the same as the scalar loop
+__attribute__((target("avx")))
+static void lerp_array_avx(float* dst, const float* s, const float* e, float t, int count) {
+    __m256 u8 = _mm256_set1_ps(1 - t), t8 = _mm256_set1_ps(t);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 d = _mm256_add_ps(_mm256_mul_ps(u8, _mm256_loadu_ps(s + i)), _mm256_mul_ps(t8, _mm256_loadu_ps(e + i)));
+        _mm256_storeu_ps(dst + i, d);
+    }
+    _mm256_zeroupper();
+    lerp_array_scalar(dst + i, s + i, e + i, t, count - i);
+}
+
+__attribute__((target("avx")))
+static void smoothstep_array_avx(float* dst, const float* x, int count) {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1), two = _mm256_set1_ps(2), three = _mm256_set1_ps(3);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // max and min return their second operand for nans, which keeps them like CLAMP does
+        __m256 v = _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_loadu_ps(x + i)));
+        __m256 d = _mm256_mul_ps(_mm256_mul_ps(v, v), _mm256_sub_ps(three, _mm256_mul_ps(two, v)));
+        _mm256_storeu_ps(dst + i, d);
+    }
+    _mm256_zeroupper();
+    smoothstep_array_scalar(dst + i, x + i, count - i);
+}
+
+#endif  // FAST_MATH_SIMD_X86
+
+static struct {
+    Fast_Math_Sincos sincos;
+    Fast_Math_Normalize2 normalize2;
+    Fast_Math_Normalize3 normalize3;
+    Fast_Math_Lerp lerp;
+    Fast_Math_Smoothstep smoothstep;
+} fast_math_kernels;
+
+static void fast_math_pick_kernels(void) {
+    if (__atomic_load_n(&fast_math_kernels.sincos, __ATOMIC_ACQUIRE)) return;
+
+    Fast_Math_Sincos sincos = sincos_array_scalar;
+    Fast_Math_Normalize2 normalize2 = vec2_normalize_array_scalar;
+    Fast_Math_Normalize3 normalize3 = vec3_normalize_array_scalar;
+    Fast_Math_Lerp lerp = lerp_array_scalar;
+    Fast_Math_Smoothstep smoothstep = smoothstep_array_scalar;
+#ifdef FAST_MATH_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        sincos = sincos_array_avx2;
+    }
+    if (__builtin_cpu_supports("avx")) {
+        lerp = lerp_array_avx;
+        smoothstep = smoothstep_array_avx;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        normalize2 = vec2_normalize_array_sse2;
+        normalize3 = vec3_normalize_array_sse2;
+    }
+#endif  // FAST_MATH_SIMD_X86
+
+    fast_math_kernels.normalize2 = normalize2;
+    fast_math_kernels.normalize3 = normalize3;
+    fast_math_kernels.lerp = lerp;
+    fast_math_kernels.smoothstep = smoothstep;
+    __atomic_store_n(&fast_math_kernels.sincos, sincos, __ATOMIC_RELEASE);
+}
+
+void sincos_array(float* sines, float* cosines, const float* x, int count) {
+    fast_math_pick_kernels();
+    fast_math_kernels.sincos(sines, cosines, x, count);
+}
+
+void vec2_normalize_array(vec2* dst, const vec2* src, int count, bool refine) {
+    fast_math_pick_kernels();
+    fast_math_kernels.normalize2(dst, src, count, refine);
+}
+
+void vec3_normalize_array(vec3* dst, const vec3* src, int count, bool refine) {
+    fast_math_pick_kernels();
+    fast_math_kernels.normalize3(dst, src, count, refine);
+}
+
+void lerp_array(float* dst, const float* s, const float* e, float t, int count) {
+    fast_math_pick_kernels();
+    fast_math_kernels.lerp(dst, s, e, t, count);
+}
+
+void smoothstep_array(float* dst, const float* x, int count) {
+    fast_math_pick_kernels();
+    fast_math_kernels.smoothstep(dst, x, count);
+}
+
+#endif // FAST_MATH_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _FAST_MATH
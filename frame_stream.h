@@ -0,0 +1,302 @@
+#ifndef _FRAME_STREAM
+#define _FRAME_STREAM
+
+// writes successive Canvas frames into one file descriptor (a file, a pipe into ffmpeg, stdout) instead of a file per frame
+// raw is the bare rgb24 bytes (ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH), ppm a P6 image per frame (-f image2pipe),
+// y4m a YUV4MPEG2 stream in 4:4:4 with bt.601 limited range
+// a frame is copied (and converted) into one of two buffers and written by a background thread while the next one renders,
+// with dirty rectangles only the regions that changed are copied
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "utility.h"
+#include "raster.h"
+
+typedef enum {
+    FRAME_STREAM_RAW,
+    FRAME_STREAM_PPM,
+    FRAME_STREAM_Y4M,
+} Frame_Stream_Format;
+
+typedef struct {
+    int fd;
+    bool owns_fd;
+    Frame_Stream_Format format;
+    int width;
+    int height;
+    int error_code;       // 0 if no errors
+    uint64_t frames;
+
+    unsigned char* buffers[2];  // frame header followed by the pixels in the stream format
+    size_t header_size;
+    size_t frame_size;    // header included
+    int current;          // buffer the next frame goes into
+    int filled[2];        // frames in each buffer, 0 if it has never been written to
+
+    // regions changed by the previous frame, the buffer a frame goes into still holds the one before it
+    Clip_Rect* previous_dirty;
+    int previous_count;   // -1 for the whole frame
+    int previous_capacity;
+
+    bool threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;          // buffer the background thread should write, -1 if none
+    uint64_t pending_frame;  // number of the frame in it, for errors
+    bool quit;
+} Frame_Stream;
+
+bool frame_stream_open(Frame_Stream* stream, const char* path, Frame_Stream_Format format, int width, int height, int fps);
+bool frame_stream_init_fd(Frame_Stream* stream, int fd, Frame_Stream_Format format, int width, int height, int fps);
+// returns once the frame is copied, waits only if the frame before the last one is still being written
+bool frame_stream_write(Frame_Stream* stream, Canvas canvas);
+// only the pixels inside the rectangles changed since the last frame
+bool frame_stream_write_dirty(Frame_Stream* stream, Canvas canvas, const Clip_Rect* dirty, int count);
+// writes what is left, returns false if any write failed
+bool frame_stream_close(Frame_Stream* stream);
+
+#ifdef FRAME_STREAM_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static bool frame_stream_write_all(int fd, const unsigned char* data, size_t size) {
+    while (size) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static void frame_stream_flush_buffer(Frame_Stream* stream, int index, uint64_t frame) {
+    if (!frame_stream_write_all(stream->fd, stream->buffers[index], stream->frame_size)) {
+        fprintf(stderr, "Could not write frame %llu of a frame stream\n", (unsigned long long)frame);
+        __atomic_store_n(&stream->error_code, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void* frame_stream_thread(void* arg) {
+    Frame_Stream* stream = (Frame_Stream*)arg;
+    pthread_mutex_lock(&stream->lock);
+    for (;;) {
+        while (stream->pending < 0 && !stream->quit) {
+            pthread_cond_wait(&stream->cond, &stream->lock);
+        }
+        if (stream->pending < 0) break;  // quit once nothing is left to write
+
+        int index = stream->pending;
+        uint64_t frame = stream->pending_frame;
+        pthread_mutex_unlock(&stream->lock);
+        frame_stream_flush_buffer(stream, index, frame);
+        pthread_mutex_lock(&stream->lock);
+
+        stream->pending = -1;
+        pthread_cond_broadcast(&stream->cond);
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+bool frame_stream_init_fd(Frame_Stream* stream, int fd, Frame_Stream_Format format, int width, int height, int fps) {
+    memset(stream, 0, sizeof(*stream));
+    stream->fd = fd;
+    stream->format = format;
+    stream->width = width;
+    stream->height = height;
+    stream->pending = -1;
+    stream->previous_count = -1;
+
+    char header[64];
+    int header_size = 0;
+    size_t pixels = (size_t)width * height * 3;
+    if (format == FRAME_STREAM_PPM) {
+        header_size = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    }
+    else if (format == FRAME_STREAM_Y4M) {
+        char stream_header[128];
+        int n = snprintf(stream_header, sizeof(stream_header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=LIMITED\n", width, height, fps > 0 ? fps : 30);
+        if (!frame_stream_write_all(fd, (const unsigned char*)stream_header, n)) {
+            fprintf(stderr, "Could not write the header of a y4m stream\n");
+            stream->error_code = 1;
+            return false;
+        }
+        header_size = snprintf(header, sizeof(header), "FRAME\n");
+    }
+    stream->header_size = header_size;
+    stream->frame_size = header_size + pixels;
+
+    for (int i = 0; i < 2; i++) {
+        stream->buffers[i] = (unsigned char*)aligned_alloc(64, (stream->frame_size + 63) & ~(size_t)63);
+        if (!stream->buffers[i]) {
+            fprintf(stderr, "Memory allocation failure creating a %dx%d frame stream\n", width, height);
+            stream->error_code = 1;
+            return false;
+        }
+        memcpy(stream->buffers[i], header, header_size);
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+    stream->threaded = pthread_create(&stream->thread, NULL, frame_stream_thread, stream) == 0;
+    if (!stream->threaded) {
+        // frames are then written on the calling thread
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->cond);
+    }
+    return true;
+}
+
+bool frame_stream_open(Frame_Stream* stream, const char* path, Frame_Stream_Format format, int width, int height, int fps) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file %s\n", path);
+        memset(stream, 0, sizeof(*stream));
+        stream->fd = -1;
+        stream->error_code = 1;
+        return false;
+    }
+
+    bool ok = frame_stream_init_fd(stream, fd, format, width, height, fps);
+    stream->owns_fd = true;
+    return ok;
+}
+
+// bt.601 limited range in 8 bit fixed point
+static void frame_stream_yuv_row(unsigned char* y_out, unsigned char* u_out, unsigned char* v_out, const rgb_t* row, int count) {
+    for (int i = 0; i < count; i++) {
+        int r = row[i].r, g = row[i].g, b = row[i].b;
+        y_out[i] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u_out[i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v_out[i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+static void frame_stream_copy_rect(Frame_Stream* stream, unsigned char* pixels, Canvas canvas, Clip_Rect r) {
+    if (r.x0 < 0) r.x0 = 0;
+    if (r.y0 < 0) r.y0 = 0;
+    if (r.x1 > stream->width) r.x1 = stream->width;
+    if (r.y1 > stream->height) r.y1 = stream->height;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1) return;
+
+    size_t plane = (size_t)stream->width * stream->height;
+    for (int y = r.y0; y < r.y1; y++) {
+        const rgb_t* row = canvas.canvas + (size_t)y * canvas.width + r.x0;
+        size_t at = (size_t)y * stream->width + r.x0;
+        if (stream->format == FRAME_STREAM_Y4M) {
+            frame_stream_yuv_row(pixels + at, pixels + plane + at, pixels + 2 * plane + at, row, r.x1 - r.x0);
+        }
+        else {
+            memcpy(pixels + at * 3, row, (size_t)(r.x1 - r.x0) * 3);
+        }
+    }
+}
+
+// the regions to copy for this frame are its own dirty ones and the previous frame's, count < 0 meaning everything
+static void frame_stream_remember_dirty(Frame_Stream* stream, const Clip_Rect* dirty, int count) {
+    if (count < 0) {
+        stream->previous_count = -1;
+        return;
+    }
+    if (count > 0 && count > stream->previous_capacity) {
+        Clip_Rect* rects = (Clip_Rect*)realloc(stream->previous_dirty, count * sizeof(Clip_Rect));
+        if (!rects) {
+            stream->previous_count = -1;
+            return;
+        }
+        stream->previous_dirty = rects;
+        stream->previous_capacity = count;
+    }
+    if (count) memcpy(stream->previous_dirty, dirty, count * sizeof(Clip_Rect));
+    stream->previous_count = count;
+}
+
+bool frame_stream_write_dirty(Frame_Stream* stream, Canvas canvas, const Clip_Rect* dirty, int count) {
+    if (!stream->buffers[1]) return false;
+    if (canvas.width != stream->width || canvas.height != stream->height) {
+        fprintf(stderr, "Frame of %dx%d written to a %dx%d frame stream\n", canvas.width, canvas.height, stream->width, stream->height);
+        return false;
+    }
+
+    int index = stream->current;
+    unsigned char* pixels = stream->buffers[index] + stream->header_size;
+    Clip_Rect everything = canvas_rect(canvas);
+    // a buffer that was never written to, or a frame without rectangles, is copied whole
+    if (!stream->filled[index] || !dirty || count < 0 || stream->previous_count < 0) {
+        frame_stream_copy_rect(stream, pixels, canvas, everything);
+    }
+    else {
+        for (int i = 0; i < stream->previous_count; i++) {
+            frame_stream_copy_rect(stream, pixels, canvas, stream->previous_dirty[i]);
+        }
+        for (int i = 0; i < count; i++) {
+            frame_stream_copy_rect(stream, pixels, canvas, dirty[i]);
+        }
+    }
+    frame_stream_remember_dirty(stream, dirty, dirty ? count : -1);
+    stream->filled[index]++;
+
+    if (stream->threaded) {
+        pthread_mutex_lock(&stream->lock);
+        while (stream->pending >= 0) {
+            pthread_cond_wait(&stream->cond, &stream->lock);
+        }
+        stream->pending = index;
+        stream->pending_frame = stream->frames;
+        pthread_cond_broadcast(&stream->cond);
+        pthread_mutex_unlock(&stream->lock);
+    }
+    else {
+        frame_stream_flush_buffer(stream, index, stream->frames);
+    }
+
+    stream->current = 1 - index;
+    stream->frames++;
+    return __atomic_load_n(&stream->error_code, __ATOMIC_RELAXED) == 0;
+}
+
+bool frame_stream_write(Frame_Stream* stream, Canvas canvas) {
+    return frame_stream_write_dirty(stream, canvas, NULL, -1);
+}
+
+bool frame_stream_close(Frame_Stream* stream) {
+    if (stream->threaded) {
+        pthread_mutex_lock(&stream->lock);
+        stream->quit = true;
+        pthread_cond_broadcast(&stream->cond);
+        pthread_mutex_unlock(&stream->lock);
+        pthread_join(stream->thread, NULL);
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->cond);
+    }
+
+    bool ok = stream->error_code == 0;
+    if (stream->owns_fd && stream->fd >= 0 && close(stream->fd) != 0) ok = false;
+    free(stream->buffers[0]);
+    free(stream->buffers[1]);
+    free(stream->previous_dirty);
+    memset(stream, 0, sizeof(*stream));
+    stream->fd = -1;
+    return ok;
+}
+
+#endif // FRAME_STREAM_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _FRAME_STREAM
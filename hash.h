@@ -0,0 +1,195 @@
+#ifndef _HASH
+#define _HASH
+
+// seeded 64 bit hashing of byte ranges and strings
+// the function is xxh64, so the one shot and the streaming forms give the same value for the same bytes
+// use a random seed per table for anything keyed by untrusted input
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "string_builder.h"
+
+typedef struct {
+    uint64_t seed;
+    uint64_t total;              // bytes seen so far
+    uint64_t acc[4];
+    unsigned char buffer[32];    // partial stripe
+    int buffered;
+} Hash_State;
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed);
+uint64_t hash_string64(String s, uint64_t seed);
+
+void hash_init(Hash_State* state, uint64_t seed);
+void hash_update(Hash_State* state, const void* data, size_t size);
+uint64_t hash_final(const Hash_State* state);  // the state can keep being updated afterwards
+
+#ifdef HASH_IMPLEMENTATION
+
+#include <string.h>
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ull
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME_3 0x165667B19E3779F9ull
+#define HASH_PRIME_4 0x85EBCA77C2B2AE63ull
+#define HASH_PRIME_5 0x27D4EB2F165667C5ull
+
+static uint64_t hash_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t hash_read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static uint32_t hash_read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * HASH_PRIME_2;
+    acc = hash_rotl(acc, 31);
+    return acc * HASH_PRIME_1;
+}
+
+static uint64_t hash_merge_round(uint64_t h, uint64_t acc) {
+    h ^= hash_round(0, acc);
+    return h * HASH_PRIME_1 + HASH_PRIME_4;
+}
+
+// consumes all the full 32 byte stripes, returns the number of bytes consumed
+static size_t hash_stripes(uint64_t acc[4], const unsigned char* p, size_t size) {
+    const unsigned char* start = p;
+    const unsigned char* limit = p + (size & ~(size_t)31);
+    uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+    for (; p < limit; p += 32) {
+        a0 = hash_round(a0, hash_read64(p));
+        a1 = hash_round(a1, hash_read64(p + 8));
+        a2 = hash_round(a2, hash_read64(p + 16));
+        a3 = hash_round(a3, hash_read64(p + 24));
+    }
+    acc[0] = a0; acc[1] = a1; acc[2] = a2; acc[3] = a3;
+    return (size_t)(p - start);
+}
+
+static void hash_init_acc(uint64_t acc[4], uint64_t seed) {
+    acc[0] = seed + HASH_PRIME_1 + HASH_PRIME_2;
+    acc[1] = seed + HASH_PRIME_2;
+    acc[2] = seed;
+    acc[3] = seed - HASH_PRIME_1;
+}
+
+// mixes in the remaining < 32 bytes and the length
+static uint64_t hash_finish(const uint64_t acc[4], uint64_t seed, uint64_t total, const unsigned char* p, size_t size) {
+    uint64_t h;
+    if (total >= 32) {
+        h = hash_rotl(acc[0], 1) + hash_rotl(acc[1], 7) + hash_rotl(acc[2], 12) + hash_rotl(acc[3], 18);
+        h = hash_merge_round(h, acc[0]);
+        h = hash_merge_round(h, acc[1]);
+        h = hash_merge_round(h, acc[2]);
+        h = hash_merge_round(h, acc[3]);
+    }
+    else {
+        h = seed + HASH_PRIME_5;
+    }
+
+    h += total;
+
+    for (; size >= 8; p += 8, size -= 8) {
+        h ^= hash_round(0, hash_read64(p));
+        h = hash_rotl(h, 27) * HASH_PRIME_1 + HASH_PRIME_4;
+    }
+    if (size >= 4) {
+        h ^= (uint64_t)hash_read32(p) * HASH_PRIME_1;
+        h = hash_rotl(h, 23) * HASH_PRIME_2 + HASH_PRIME_3;
+        p += 4;
+        size -= 4;
+    }
+    for (; size > 0; p++, size--) {
+        h ^= *p * HASH_PRIME_5;
+        h = hash_rotl(h, 11) * HASH_PRIME_1;
+    }
+
+    // avalanche
+    h ^= h >> 33;
+    h *= HASH_PRIME_2;
+    h ^= h >> 29;
+    h *= HASH_PRIME_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t acc[4];
+    hash_init_acc(acc, seed);
+    size_t consumed = hash_stripes(acc, p, size);
+    return hash_finish(acc, seed, size, p + consumed, size - consumed);
+}
+
+uint64_t hash_string64(String s, uint64_t seed) {
+    return hash_bytes(s.data, (size_t)s.size, seed);
+}
+
+void hash_init(Hash_State* state, uint64_t seed) {
+    memset(state, 0, sizeof(*state));
+    state->seed = seed;
+    hash_init_acc(state->acc, seed);
+}
+
+void hash_update(Hash_State* state, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    state->total += size;
+
+    if (state->buffered) {
+        size_t fill = 32 - state->buffered;
+        if (size < fill) {
+            memcpy(state->buffer + state->buffered, p, size);
+            state->buffered += (int)size;
+            return;
+        }
+
+        memcpy(state->buffer + state->buffered, p, fill);
+        hash_stripes(state->acc, state->buffer, 32);
+        state->buffered = 0;
+        p += fill;
+        size -= fill;
+    }
+
+    size_t consumed = hash_stripes(state->acc, p, size);
+    memcpy(state->buffer, p + consumed, size - consumed);
+    state->buffered = (int)(size - consumed);
+}
+
+uint64_t hash_final(const Hash_State* state) {
+    return hash_finish(state->acc, state->seed, state->total, state->buffer, (size_t)state->buffered);
+}
+
+#undef HASH_PRIME_1
+#undef HASH_PRIME_2
+#undef HASH_PRIME_3
+#undef HASH_PRIME_4
+#undef HASH_PRIME_5
+
+#endif // HASH_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _HASH
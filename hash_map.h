@@ -0,0 +1,288 @@
+#ifndef _HASH_MAP
+#define _HASH_MAP
+
+// open addressing hash map from String to a fixed size value
+// control bytes hold 7 bits of the hash per slot and are probed a group of 16 at a time (sse2 when available),
+// the full hash of every key is cached so the keys are only compared when the whole hash matches
+// the map stores the key views, not the bytes, so the bytes have to outlive the map
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "string_builder.h"
+#include "hash.h"
+
+#define STRING_MAP_GROUP_WIDTH 16
+
+typedef struct {
+    String key;
+    uint64_t hash;
+} String_Map_Slot;
+
+typedef struct {
+    uint8_t* ctrl;            // capacity + STRING_MAP_GROUP_WIDTH bytes, the first group is mirrored past the end
+    String_Map_Slot* slots;
+    char* values;
+    int value_size;
+    int capacity;             // 0 or a power of two >= STRING_MAP_GROUP_WIDTH
+    int size;
+    int growth_left;          // inserts into empty slots left before the table has to be rehashed
+    uint64_t seed;            // set before the first insertion
+} String_Map;
+
+String_Map make_string_map(int value_size);
+void string_map_free(String_Map* map);
+void string_map_clear(String_Map* map);
+void string_map_reserve(String_Map* map, int count);  // room for count keys without rehashing
+void string_map_rehash(String_Map* map, int count);   // rebuilds the table for count keys, dropping the tombstones
+void* string_map_get(String_Map* map, String key);    // pointer to the value or NULL
+// inserts or overwrites, a NULL value leaves an existing value alone and zeroes a new one
+// the returned pointer is valid until the next insertion
+void* string_map_put(String_Map* map, String key, const void* value);
+bool string_map_remove(String_Map* map, String key);
+// walks the entries in table order, cursor starts at 0
+bool string_map_iterate(String_Map* map, int* cursor, String* key, void** value);
+
+#ifdef HASH_MAP_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STRING_MAP_SSE2
+#endif
+
+#define STRING_MAP_EMPTY   ((uint8_t)0x80)
+#define STRING_MAP_DELETED ((uint8_t)0xfe)
+
+static uint32_t string_map_match(const uint8_t* group, uint8_t h2) {
+#ifdef STRING_MAP_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < STRING_MAP_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(group[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+// empty and deleted are the only control bytes with the high bit set, empty is the one with bit 0 clear
+static uint32_t string_map_match_empty_or_deleted(const uint8_t* group) {
+#ifdef STRING_MAP_SSE2
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < STRING_MAP_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static uint32_t string_map_match_empty(const uint8_t* group) {
+    return string_map_match(group, STRING_MAP_EMPTY);
+}
+
+static void string_map_set_ctrl(String_Map* map, int index, uint8_t c) {
+    map->ctrl[index] = c;
+    if (index < STRING_MAP_GROUP_WIDTH) {
+        map->ctrl[map->capacity + index] = c;
+    }
+}
+
+static int string_map_max_load(int capacity) {
+    return capacity - capacity / 8;
+}
+
+static void string_map_allocate(String_Map* map, int capacity) {
+    size_t ctrl_size = ((size_t)capacity + STRING_MAP_GROUP_WIDTH + 15) & ~(size_t)15;
+    size_t slots_size = (size_t)capacity * sizeof(String_Map_Slot);
+    size_t values_size = ((size_t)capacity * map->value_size + 15) & ~(size_t)15;
+
+    char* mem = (char*)malloc(ctrl_size + slots_size + values_size);
+    if (!mem) {
+        fprintf(stderr, "Memory allocation failure growing a string map to %d slots\n", capacity);
+        exit(1);
+    }
+
+    map->ctrl = (uint8_t*)mem;
+    map->slots = (String_Map_Slot*)(mem + ctrl_size);
+    map->values = mem + ctrl_size + slots_size;
+    map->capacity = capacity;
+    map->size = 0;
+    map->growth_left = string_map_max_load(capacity);
+    memset(map->ctrl, STRING_MAP_EMPTY, (size_t)capacity + STRING_MAP_GROUP_WIDTH);
+}
+
+String_Map make_string_map(int value_size) {
+    String_Map map;
+    memset(&map, 0, sizeof(map));
+    map.value_size = value_size;
+    return map;
+}
+
+void string_map_free(String_Map* map) {
+    free(map->ctrl);  // the slots and values share the allocation
+    int value_size = map->value_size;
+    uint64_t seed = map->seed;
+    *map = make_string_map(value_size);
+    map->seed = seed;
+}
+
+void string_map_clear(String_Map* map) {
+    if (!map->capacity) return;
+    memset(map->ctrl, STRING_MAP_EMPTY, (size_t)map->capacity + STRING_MAP_GROUP_WIDTH);
+    map->size = 0;
+    map->growth_left = string_map_max_load(map->capacity);
+}
+
+// first empty or deleted slot on the probe sequence of hash
+static int string_map_find_free(String_Map* map, uint64_t hash) {
+    int mask = map->capacity - 1;
+    int pos = (int)(hash >> 7) & mask;
+    for (int stride = STRING_MAP_GROUP_WIDTH;; stride += STRING_MAP_GROUP_WIDTH) {
+        uint32_t free_mask = string_map_match_empty_or_deleted(map->ctrl + pos);
+        if (free_mask) {
+            return (pos + __builtin_ctz(free_mask)) & mask;
+        }
+        pos = (pos + stride) & mask;
+    }
+}
+
+static int string_map_find(String_Map* map, String key, uint64_t hash) {
+    if (!map->capacity) return -1;
+
+    int mask = map->capacity - 1;
+    int pos = (int)(hash >> 7) & mask;
+    uint8_t h2 = (uint8_t)(hash & 0x7f);
+    for (int stride = STRING_MAP_GROUP_WIDTH;; stride += STRING_MAP_GROUP_WIDTH) {
+        const uint8_t* group = map->ctrl + pos;
+        for (uint32_t match = string_map_match(group, h2); match; match &= match - 1) {
+            int index = (pos + __builtin_ctz(match)) & mask;
+            String_Map_Slot* slot = &map->slots[index];
+            if (slot->hash == hash && slot->key.size == key.size && memcmp(slot->key.data, key.data, key.size) == 0) {
+                return index;
+            }
+        }
+
+        if (string_map_match_empty(group)) return -1;
+        pos = (pos + stride) & mask;
+    }
+}
+
+void string_map_rehash(String_Map* map, int count) {
+    if (count < map->size) count = map->size;
+
+    int capacity = STRING_MAP_GROUP_WIDTH;
+    while (string_map_max_load(capacity) < count) capacity *= 2;
+
+    String_Map old = *map;
+    string_map_allocate(map, capacity);
+
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.ctrl[i] & 0x80) continue;
+
+        uint64_t hash = old.slots[i].hash;
+        int index = string_map_find_free(map, hash);
+        string_map_set_ctrl(map, index, (uint8_t)(hash & 0x7f));
+        map->slots[index] = old.slots[i];
+        memcpy(map->values + (size_t)index * map->value_size, old.values + (size_t)i * old.value_size, map->value_size);
+    }
+    map->size = old.size;
+    map->growth_left -= old.size;
+
+    free(old.ctrl);
+}
+
+void string_map_reserve(String_Map* map, int count) {
+    if (count - map->size > map->growth_left) {
+        string_map_rehash(map, count);
+    }
+}
+
+void* string_map_get(String_Map* map, String key) {
+    int index = string_map_find(map, key, hash_string64(key, map->seed));
+    return index < 0 ? NULL : map->values + (size_t)index * map->value_size;
+}
+
+void* string_map_put(String_Map* map, String key, const void* value) {
+    uint64_t hash = hash_string64(key, map->seed);
+    int index = string_map_find(map, key, hash);
+
+    if (index < 0) {
+        if (map->capacity) index = string_map_find_free(map, hash);
+        if (!map->capacity || (map->growth_left == 0 && map->ctrl[index] == STRING_MAP_EMPTY)) {
+            // tombstones are dropped by rehashing in place if they make up a big part of the table, otherwise it grows
+            int count = map->size + 1;
+            if (map->size + 1 > string_map_max_load(map->capacity) / 2) count = map->size * 2 + 1;
+            string_map_rehash(map, count);
+            index = string_map_find_free(map, hash);
+        }
+
+        if (map->ctrl[index] == STRING_MAP_EMPTY) map->growth_left -= 1;
+        string_map_set_ctrl(map, index, (uint8_t)(hash & 0x7f));
+        map->slots[index] = (String_Map_Slot){.key = key, .hash = hash};
+        map->size += 1;
+
+        if (!value) memset(map->values + (size_t)index * map->value_size, 0, map->value_size);
+    }
+
+    void* slot_value = map->values + (size_t)index * map->value_size;
+    if (value) memcpy(slot_value, value, map->value_size);
+    return slot_value;
+}
+
+bool string_map_remove(String_Map* map, String key) {
+    int index = string_map_find(map, key, hash_string64(key, map->seed));
+    if (index < 0) return false;
+
+    // the slot can go back to empty if no probe sequence ever saw its group full
+    int mask = map->capacity - 1;
+    int before = (index - STRING_MAP_GROUP_WIDTH) & mask;
+    uint32_t empty_after = string_map_match_empty(map->ctrl + index);
+    uint32_t empty_before = string_map_match_empty(map->ctrl + before);
+    bool was_never_full = empty_before && empty_after &&
+                          __builtin_ctz(empty_after) + __builtin_clz(empty_before << 16) < STRING_MAP_GROUP_WIDTH;
+
+    if (was_never_full) {
+        string_map_set_ctrl(map, index, STRING_MAP_EMPTY);
+        map->growth_left += 1;
+    }
+    else {
+        string_map_set_ctrl(map, index, STRING_MAP_DELETED);
+    }
+    map->size -= 1;
+    return true;
+}
+
+bool string_map_iterate(String_Map* map, int* cursor, String* key, void** value) {
+    for (; *cursor < map->capacity; *cursor += 1) {
+        int i = *cursor;
+        if (map->ctrl[i] & 0x80) continue;
+
+        if (key) *key = map->slots[i].key;
+        if (value) *value = map->values + (size_t)i * map->value_size;
+        *cursor += 1;
+        return true;
+    }
+    return false;
+}
+
+#undef STRING_MAP_EMPTY
+#undef STRING_MAP_DELETED
+
+#endif // HASH_MAP_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _HASH_MAP
@@ -0,0 +1,603 @@
+#ifndef _IMAGE
+#define _IMAGE
+
+// streaming QOI and PNG encoders for Canvas
+// the writers take one row at a time and only keep a fixed amount of state and output buffer, whatever the image size
+// PNG can be stored (no compression, the fastest) or go through a single pass deflate with fixed huffman codes
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utility.h"
+
+#define IMAGE_BUFFER_SIZE (64 * 1024)
+#define IMAGE_DEFLATE_WINDOW (32 * 1024)
+#define IMAGE_DEFLATE_HASH_BITS 14
+
+typedef struct {
+    FILE* file;
+    int width;
+    int height;
+    int row;
+    int error_code;  // 0 if no errors
+    uint32_t index[64];
+    uint32_t previous;
+    int run;
+    int size;
+    unsigned char buffer[IMAGE_BUFFER_SIZE];
+} Qoi_Writer;
+
+typedef enum {
+    PNG_STORED,
+    PNG_FAST,
+} Png_Compression;
+
+typedef struct {
+    unsigned char window[2 * IMAGE_DEFLATE_WINDOW];  // input history and lookahead
+    int filled;
+    int pos;  // next byte to encode
+    int32_t head[1 << IMAGE_DEFLATE_HASH_BITS];  // last position of each 4 byte hash, -1 if none
+} Png_Deflate;
+
+typedef struct {
+    FILE* file;
+    int width;
+    int height;
+    int row;
+    int error_code;  // 0 if no errors
+    Png_Compression compression;
+    unsigned char* rows;  // previous row and the filtered current row
+    uint32_t adler;
+    uint64_t bits;
+    int bit_count;
+    int size;  // bytes in buffer, they go out as one IDAT chunk
+    unsigned char buffer[IMAGE_BUFFER_SIZE];
+    Png_Deflate* deflate;  // stored blocks are collected in its window
+} Png_Writer;
+
+// the writers are big, keep them off small stacks
+bool qoi_begin(Qoi_Writer* writer, const char* file_name, int width, int height);
+void qoi_write_row(Qoi_Writer* writer, const rgb_t* row);
+bool qoi_end(Qoi_Writer* writer);  // false if anything failed along the way
+
+bool png_begin(Png_Writer* writer, const char* file_name, int width, int height, Png_Compression compression);
+void png_write_row(Png_Writer* writer, const rgb_t* row);
+bool png_end(Png_Writer* writer);
+
+bool output_qoi(const char* file_name, Canvas canvas);
+bool output_png(const char* file_name, Canvas canvas, Png_Compression compression);
+
+#ifdef IMAGE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+static void image_put_u32_be(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void image_write(FILE* file, int* error_code, const void* data, size_t size) {
+    if (size && fwrite(data, 1, size, file) != size) *error_code = 1;
+}
+
+// QOI
+
+static void qoi_flush(Qoi_Writer* writer) {
+    image_write(writer->file, &writer->error_code, writer->buffer, writer->size);
+    writer->size = 0;
+}
+
+bool qoi_begin(Qoi_Writer* writer, const char* file_name, int width, int height) {
+    memset(writer, 0, offsetof(Qoi_Writer, buffer));
+    writer->file = fopen(file_name, "wb");
+    if (!writer->file) {
+        fprintf(stderr, "Could not open file %s\n", file_name);
+        writer->error_code = 1;
+        return false;
+    }
+
+    writer->width = width;
+    writer->height = height;
+    writer->previous = 0xff000000u;  // r, g, b, a from the low byte up
+
+    unsigned char* header = writer->buffer;
+    memcpy(header, "qoif", 4);
+    image_put_u32_be(header + 4, (uint32_t)width);
+    image_put_u32_be(header + 8, (uint32_t)height);
+    header[12] = 3;  // channels
+    header[13] = 0;  // srgb
+    writer->size = 14;
+    return true;
+}
+
+void qoi_write_row(Qoi_Writer* writer, const rgb_t* row) {
+    if (!writer->file) return;
+
+    uint32_t previous = writer->previous;
+    int run = writer->run;
+    unsigned char* out = writer->buffer;
+    int size = writer->size;
+
+    for (int x = 0; x < writer->width; x++) {
+        // worst case per pixel is a run byte followed by a 4 byte rgb op
+        if (size > IMAGE_BUFFER_SIZE - 8) {
+            writer->size = size;
+            qoi_flush(writer);
+            size = 0;
+        }
+
+        rgb_t p = row[x];
+        uint32_t pixel = (uint32_t)p.r | (uint32_t)p.g << 8 | (uint32_t)p.b << 16 | 0xff000000u;
+        if (pixel == previous) {
+            if (++run == 62) {
+                out[size++] = (unsigned char)(0xc0 | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run) {
+            out[size++] = (unsigned char)(0xc0 | (run - 1));
+            run = 0;
+        }
+
+        int hash = (p.r * 3 + p.g * 5 + p.b * 7 + 255 * 11) % 64;
+        if (writer->index[hash] == pixel) {
+            out[size++] = (unsigned char)hash;
+        }
+        else {
+            writer->index[hash] = pixel;
+
+            signed char dr = (signed char)(p.r - (unsigned char)previous);
+            signed char dg = (signed char)(p.g - (unsigned char)(previous >> 8));
+            signed char db = (signed char)(p.b - (unsigned char)(previous >> 16));
+            signed char dr_dg = (signed char)(dr - dg);
+            signed char db_dg = (signed char)(db - dg);
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out[size++] = (unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+            }
+            else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                out[size++] = (unsigned char)(0x80 | (dg + 32));
+                out[size++] = (unsigned char)((dr_dg + 8) << 4 | (db_dg + 8));
+            }
+            else {
+                out[size++] = 0xfe;
+                out[size++] = p.r;
+                out[size++] = p.g;
+                out[size++] = p.b;
+            }
+        }
+        previous = pixel;
+    }
+
+    writer->previous = previous;
+    writer->run = run;
+    writer->size = size;
+    writer->row += 1;
+}
+
+bool qoi_end(Qoi_Writer* writer) {
+    if (!writer->file) return false;
+
+    if (writer->row != writer->height) writer->error_code = 1;
+    if (writer->size > IMAGE_BUFFER_SIZE - 9) qoi_flush(writer);
+    if (writer->run) writer->buffer[writer->size++] = (unsigned char)(0xc0 | (writer->run - 1));
+
+    static const unsigned char end_marker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    memcpy(writer->buffer + writer->size, end_marker, sizeof(end_marker));
+    writer->size += sizeof(end_marker);
+    qoi_flush(writer);
+
+    if (fclose(writer->file) != 0) writer->error_code = 1;
+    writer->file = NULL;
+    return writer->error_code == 0;
+}
+
+bool output_qoi(const char* file_name, Canvas canvas) {
+    Qoi_Writer* writer = (Qoi_Writer*)malloc(sizeof(Qoi_Writer));
+    if (!writer) return false;
+
+    bool ok = qoi_begin(writer, file_name, canvas.width, canvas.height);
+    if (ok) {
+        for (int y = 0; y < canvas.height; y++) {
+            qoi_write_row(writer, canvas.canvas + (size_t)y * canvas.width);
+        }
+        ok = qoi_end(writer);
+    }
+
+    free(writer);
+    return ok;
+}
+
+// PNG
+
+static struct {
+    uint32_t crc[8][256];             // slice by 8
+    uint16_t literal_code[288];       // fixed huffman codes, bit reversed for the lsb first stream
+    uint8_t literal_bits[288];
+    uint8_t length_symbol[259];       // match length -> length symbol - 257
+    uint8_t distance_symbol[512];     // see png_distance_symbol
+} png_tables;
+
+static pthread_once_t png_tables_once = PTHREAD_ONCE_INIT;
+
+static const uint16_t png_length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t png_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t png_distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                               1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t png_distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t png_reverse_bits(uint32_t code, int bits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < bits; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    return reversed;
+}
+
+static void png_init_tables(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        png_tables.crc[0][i] = c;
+    }
+    for (int i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            uint32_t c = png_tables.crc[t - 1][i];
+            png_tables.crc[t][i] = (c >> 8) ^ png_tables.crc[0][c & 0xff];
+        }
+    }
+
+    for (int i = 0; i < 288; i++) {
+        uint32_t code;
+        int bits;
+        if (i < 144)      { code = 0x30 + i;        bits = 8; }
+        else if (i < 256) { code = 0x190 + i - 144; bits = 9; }
+        else if (i < 280) { code = i - 256;         bits = 7; }
+        else              { code = 0xc0 + i - 280;  bits = 8; }
+        png_tables.literal_code[i] = (uint16_t)png_reverse_bits(code, bits);
+        png_tables.literal_bits[i] = (uint8_t)bits;
+    }
+
+    for (int symbol = 0; symbol < 29; symbol++) {
+        int end = symbol == 28 ? 259 : png_length_base[symbol + 1];
+        for (int length = png_length_base[symbol]; length < end; length++) {
+            png_tables.length_symbol[length] = (uint8_t)symbol;
+        }
+    }
+
+    for (int symbol = 0; symbol < 30; symbol++) {
+        int end = symbol == 29 ? 32769 : png_distance_base[symbol + 1];
+        for (int distance = png_distance_base[symbol]; distance < end; distance++) {
+            if (distance <= 256) png_tables.distance_symbol[distance - 1] = (uint8_t)symbol;
+            else png_tables.distance_symbol[256 + ((distance - 1) >> 7)] = (uint8_t)symbol;
+        }
+    }
+}
+
+static int png_distance_symbol(int distance) {
+    return distance <= 256 ? png_tables.distance_symbol[distance - 1] : png_tables.distance_symbol[256 + ((distance - 1) >> 7)];
+}
+
+static uint32_t png_crc_update(uint32_t crc, const unsigned char* p, size_t size) {
+    crc = ~crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        crc = png_tables.crc[7][lo & 0xff] ^ png_tables.crc[6][(lo >> 8) & 0xff] ^
+              png_tables.crc[5][(lo >> 16) & 0xff] ^ png_tables.crc[4][lo >> 24] ^
+              png_tables.crc[3][p[4]] ^ png_tables.crc[2][p[5]] ^ png_tables.crc[1][p[6]] ^ png_tables.crc[0][p[7]];
+    }
+    for (; size > 0; p++, size--) {
+        crc = png_tables.crc[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t png_adler_update(uint32_t adler, const unsigned char* p, size_t size) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t n = size < 5552 ? size : 5552;  // largest run before b can overflow
+        size -= n;
+        for (; n > 0; n--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+static void png_write_chunk(Png_Writer* writer, const char* type, const unsigned char* data, uint32_t size) {
+    unsigned char header[8];
+    image_put_u32_be(header, size);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = png_crc_update(0, header + 4, 4);
+    crc = png_crc_update(crc, data, size);
+
+    unsigned char footer[4];
+    image_put_u32_be(footer, crc);
+    image_write(writer->file, &writer->error_code, header, sizeof(header));
+    image_write(writer->file, &writer->error_code, data, size);
+    image_write(writer->file, &writer->error_code, footer, sizeof(footer));
+}
+
+static void png_flush_idat(Png_Writer* writer) {
+    if (writer->size) png_write_chunk(writer, "IDAT", writer->buffer, (uint32_t)writer->size);
+    writer->size = 0;
+}
+
+static void png_put_bytes(Png_Writer* writer, const unsigned char* data, int size) {
+    while (size > 0) {
+        if (writer->size == IMAGE_BUFFER_SIZE) png_flush_idat(writer);
+        int n = IMAGE_BUFFER_SIZE - writer->size;
+        if (n > size) n = size;
+        memcpy(writer->buffer + writer->size, data, n);
+        writer->size += n;
+        data += n;
+        size -= n;
+    }
+}
+
+static void png_put_bits(Png_Writer* writer, uint32_t value, int bits) {
+    writer->bits |= (uint64_t)value << writer->bit_count;
+    writer->bit_count += bits;
+    if (writer->bit_count >= 32) {
+        if (writer->size > IMAGE_BUFFER_SIZE - 4) png_flush_idat(writer);
+        uint32_t word = (uint32_t)writer->bits;
+        unsigned char* out = writer->buffer + writer->size;
+        out[0] = (unsigned char)word;
+        out[1] = (unsigned char)(word >> 8);
+        out[2] = (unsigned char)(word >> 16);
+        out[3] = (unsigned char)(word >> 24);
+        writer->size += 4;
+        writer->bits >>= 32;
+        writer->bit_count -= 32;
+    }
+}
+
+static void png_align_bits(Png_Writer* writer) {
+    while (writer->bit_count > 0) {
+        unsigned char byte = (unsigned char)writer->bits;
+        png_put_bytes(writer, &byte, 1);
+        writer->bits >>= 8;
+        writer->bit_count -= writer->bit_count < 8 ? writer->bit_count : 8;
+    }
+    writer->bits = 0;
+}
+
+static void png_stored_block(Png_Writer* writer, bool final) {
+    Png_Deflate* deflate = writer->deflate;
+    unsigned char header[5];
+    header[0] = final ? 1 : 0;
+    header[1] = (unsigned char)deflate->filled;
+    header[2] = (unsigned char)(deflate->filled >> 8);
+    header[3] = (unsigned char)~header[1];
+    header[4] = (unsigned char)~header[2];
+    png_put_bytes(writer, header, sizeof(header));
+    png_put_bytes(writer, deflate->window, deflate->filled);
+    deflate->filled = 0;
+}
+
+static uint32_t png_read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void png_put_literal(Png_Writer* writer, int symbol) {
+    png_put_bits(writer, png_tables.literal_code[symbol], png_tables.literal_bits[symbol]);
+}
+
+// greedy lz77 with a single candidate per hash, everything up to limit gets encoded
+static void png_deflate_run(Png_Writer* writer, int limit) {
+    Png_Deflate* deflate = writer->deflate;
+    const unsigned char* window = deflate->window;
+    int pos = deflate->pos;
+
+    while (pos < limit) {
+        if (pos + 4 <= deflate->filled) {
+            uint32_t next = png_read32(window + pos);
+            uint32_t hash = (next * 2654435761u) >> (32 - IMAGE_DEFLATE_HASH_BITS);
+            int candidate = deflate->head[hash];
+            deflate->head[hash] = pos;
+
+            if (candidate >= 0 && pos - candidate <= IMAGE_DEFLATE_WINDOW && png_read32(window + candidate) == next) {
+                int max_length = deflate->filled - pos < 258 ? deflate->filled - pos : 258;
+                int length = 4;
+                while (length < max_length && window[candidate + length] == window[pos + length]) length++;
+
+                int distance = pos - candidate;
+                int length_symbol = png_tables.length_symbol[length];
+                png_put_literal(writer, 257 + length_symbol);
+                png_put_bits(writer, length - png_length_base[length_symbol], png_length_extra[length_symbol]);
+                int distance_symbol = png_distance_symbol(distance);
+                png_put_bits(writer, png_reverse_bits(distance_symbol, 5), 5);
+                png_put_bits(writer, distance - png_distance_base[distance_symbol], png_distance_extra[distance_symbol]);
+
+                pos += length;
+                continue;
+            }
+        }
+
+        png_put_literal(writer, window[pos]);
+        pos++;
+    }
+
+    deflate->pos = pos;
+}
+
+static void png_deflate_feed(Png_Writer* writer, const unsigned char* data, int size) {
+    Png_Deflate* deflate = writer->deflate;
+    writer->adler = png_adler_update(writer->adler, data, size);
+
+    // stored blocks hold at most 65535 bytes
+    int capacity = writer->compression == PNG_STORED ? 0xffff : (int)sizeof(deflate->window);
+    while (size > 0) {
+        if (deflate->filled == capacity) {
+            if (writer->compression == PNG_STORED) {
+                png_stored_block(writer, false);
+            }
+            else {
+                // keep the last window of history, positions in the hash table move with it
+                memmove(deflate->window, deflate->window + IMAGE_DEFLATE_WINDOW, IMAGE_DEFLATE_WINDOW);
+                deflate->filled -= IMAGE_DEFLATE_WINDOW;
+                deflate->pos -= IMAGE_DEFLATE_WINDOW;
+                for (int i = 0; i < (1 << IMAGE_DEFLATE_HASH_BITS); i++) {
+                    int32_t position = deflate->head[i] - IMAGE_DEFLATE_WINDOW;
+                    deflate->head[i] = position < 0 ? -1 : position;
+                }
+            }
+        }
+
+        int n = capacity - deflate->filled;
+        if (n > size) n = size;
+        memcpy(deflate->window + deflate->filled, data, n);
+        deflate->filled += n;
+        data += n;
+        size -= n;
+
+        // leave a full match worth of lookahead unencoded until more data or the end arrives
+        if (writer->compression == PNG_FAST && deflate->filled - 258 > deflate->pos) {
+            png_deflate_run(writer, deflate->filled - 258);
+        }
+    }
+}
+
+bool png_begin(Png_Writer* writer, const char* file_name, int width, int height, Png_Compression compression) {
+    pthread_once(&png_tables_once, png_init_tables);
+
+    memset(writer, 0, offsetof(Png_Writer, buffer));
+    writer->compression = compression;
+    writer->width = width;
+    writer->height = height;
+    writer->adler = 1;
+
+    size_t row_size = (size_t)width * 3 + 1;
+    writer->rows = (unsigned char*)calloc(2, row_size);
+    writer->deflate = (Png_Deflate*)malloc(sizeof(Png_Deflate));
+    writer->file = fopen(file_name, "wb");
+    if (!writer->rows || !writer->deflate || !writer->file) {
+        if (!writer->file) fprintf(stderr, "Could not open file %s\n", file_name);
+        else fclose(writer->file);
+        free(writer->rows);
+        free(writer->deflate);
+        memset(writer, 0, offsetof(Png_Writer, buffer));
+        writer->error_code = 1;
+        return false;
+    }
+    writer->deflate->filled = 0;
+    writer->deflate->pos = 0;
+    memset(writer->deflate->head, 0xff, sizeof(writer->deflate->head));
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    image_write(writer->file, &writer->error_code, signature, sizeof(signature));
+
+    unsigned char header[13];
+    image_put_u32_be(header, (uint32_t)width);
+    image_put_u32_be(header + 4, (uint32_t)height);
+    header[8] = 8;    // bit depth
+    header[9] = 2;    // truecolour
+    header[10] = 0;   // deflate
+    header[11] = 0;   // adaptive filtering
+    header[12] = 0;   // no interlace
+    png_write_chunk(writer, "IHDR", header, sizeof(header));
+
+    // zlib header without a preset dictionary, then a single fixed huffman block for the fast mode
+    static const unsigned char zlib_header[2] = {0x78, 0x01};
+    png_put_bytes(writer, zlib_header, sizeof(zlib_header));
+    if (compression == PNG_FAST) png_put_bits(writer, 0x3, 3);
+    return true;
+}
+
+void png_write_row(Png_Writer* writer, const rgb_t* row) {
+    if (!writer->file) return;
+
+    size_t row_size = (size_t)writer->width * 3;
+    unsigned char* previous = writer->rows;
+    unsigned char* filtered = writer->rows + row_size + 1;
+    const unsigned char* pixels = (const unsigned char*)row;
+
+    if (writer->compression == PNG_STORED) {
+        // filtering only pays off with compression
+        filtered[0] = 0;
+        memcpy(filtered + 1, pixels, row_size);
+    }
+    else {
+        // up filter, runs of equal rows become zeros and the rows above are still in the window for matches
+        filtered[0] = 2;
+        for (size_t i = 0; i < row_size; i++) {
+            filtered[i + 1] = (unsigned char)(pixels[i] - previous[i]);
+        }
+        memcpy(previous, pixels, row_size);
+    }
+
+    png_deflate_feed(writer, filtered, (int)row_size + 1);
+    writer->row += 1;
+}
+
+bool png_end(Png_Writer* writer) {
+    if (!writer->file) return false;
+    if (writer->row != writer->height) writer->error_code = 1;
+
+    if (writer->compression == PNG_STORED) {
+        png_stored_block(writer, true);
+    }
+    else {
+        png_deflate_run(writer, writer->deflate->filled);
+        png_put_literal(writer, 256);
+        png_align_bits(writer);
+    }
+
+    unsigned char adler[4];
+    image_put_u32_be(adler, writer->adler);
+    png_put_bytes(writer, adler, sizeof(adler));
+    png_flush_idat(writer);
+    png_write_chunk(writer, "IEND", NULL, 0);
+
+    if (fclose(writer->file) != 0) writer->error_code = 1;
+    writer->file = NULL;
+    free(writer->rows);
+    free(writer->deflate);
+    writer->rows = NULL;
+    writer->deflate = NULL;
+    return writer->error_code == 0;
+}
+
+bool output_png(const char* file_name, Canvas canvas, Png_Compression compression) {
+    Png_Writer* writer = (Png_Writer*)malloc(sizeof(Png_Writer));
+    if (!writer) return false;
+
+    bool ok = png_begin(writer, file_name, canvas.width, canvas.height, compression);
+    if (ok) {
+        for (int y = 0; y < canvas.height; y++) {
+            png_write_row(writer, canvas.canvas + (size_t)y * canvas.width);
+        }
+        ok = png_end(writer);
+    }
+
+    free(writer);
+    return ok;
+}
+
+#endif // IMAGE_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _IMAGE
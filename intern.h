@@ -0,0 +1,170 @@
+#ifndef _INTERN
+#define _INTERN
+
+// string interning, every distinct string gets a dense 32 bit atom that can be compared instead of the bytes
+// the bytes are copied (null terminated) into arena pages and the views handed out stay valid until the pool is freed
+// in thread safe mode the pool is split into shards with a lock each, atom_string never locks
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "arena.h"
+#include "string_builder.h"
+#include "hash_map.h"
+
+typedef uint32_t Atom;
+
+#define ATOM_NONE ((Atom)0xffffffff)
+#define INTERN_SHARD_COUNT 16
+#define INTERN_FIRST_CHUNK_BITS 10  // chunk k of the atom table holds 1 << (k + INTERN_FIRST_CHUNK_BITS) atoms
+#define INTERN_CHUNK_COUNT (32 - INTERN_FIRST_CHUNK_BITS + 1)
+
+typedef struct {
+    pthread_mutex_t lock;
+    String_Map map;  // interned bytes -> atom
+    Arena arena;     // interned bytes
+} Intern_Shard;
+
+typedef struct {
+    Intern_Shard shards[INTERN_SHARD_COUNT];
+    int shard_count;  // 1 unless thread safe
+    bool thread_safe;
+    uint32_t count;
+    String* chunks[INTERN_CHUNK_COUNT];  // atom -> string, chunks never move once allocated
+} Intern_Pool;
+
+void intern_pool_init(Intern_Pool* pool, bool thread_safe);
+void intern_pool_free(Intern_Pool* pool);
+Atom intern(Intern_Pool* pool, String s);
+Atom intern_find(Intern_Pool* pool, String s);  // ATOM_NONE if s was never interned
+String atom_string(const Intern_Pool* pool, Atom atom);  // an empty string for ATOM_NONE and atoms the pool never gave out
+uint32_t intern_count(const Intern_Pool* pool);
+
+#ifdef INTERN_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+void intern_pool_init(Intern_Pool* pool, bool thread_safe) {
+    memset(pool, 0, sizeof(*pool));
+    pool->thread_safe = thread_safe;
+    pool->shard_count = thread_safe ? INTERN_SHARD_COUNT : 1;
+
+    for (int i = 0; i < pool->shard_count; i++) {
+        Intern_Shard* shard = &pool->shards[i];
+        if (thread_safe) pthread_mutex_init(&shard->lock, NULL);
+        shard->map = make_string_map(sizeof(Atom));
+        shard->map.seed = 0x9e3779b97f4a7c15ull;  // differs from the seed used to pick the shard
+        shard->arena = make_arena(0);
+    }
+}
+
+void intern_pool_free(Intern_Pool* pool) {
+    for (int i = 0; i < pool->shard_count; i++) {
+        Intern_Shard* shard = &pool->shards[i];
+        if (pool->thread_safe) pthread_mutex_destroy(&shard->lock);
+        string_map_free(&shard->map);
+        arena_free(&shard->arena);
+    }
+
+    for (int i = 0; i < INTERN_CHUNK_COUNT; i++) {
+        free(pool->chunks[i]);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+static String* intern_atom_slot(const Intern_Pool* pool, Atom atom, int* chunk_index) {
+    uint64_t j = (uint64_t)atom + (1u << INTERN_FIRST_CHUNK_BITS);
+    int k = 63 - __builtin_clzll(j) - INTERN_FIRST_CHUNK_BITS;
+    *chunk_index = k;
+
+    String* chunk = __atomic_load_n(&pool->chunks[k], __ATOMIC_ACQUIRE);
+    return chunk ? chunk + (j - (1ull << (k + INTERN_FIRST_CHUNK_BITS))) : NULL;
+}
+
+static void intern_set_atom(Intern_Pool* pool, Atom atom, String s) {
+    int k;
+    String* slot = intern_atom_slot(pool, atom, &k);
+    if (!slot) {
+        size_t chunk_size = (size_t)1 << (k + INTERN_FIRST_CHUNK_BITS);
+        String* chunk = (String*)malloc(chunk_size * sizeof(String));
+        if (!chunk) {
+            fprintf(stderr, "Memory allocation failure growing the intern pool to %u atoms\n", atom);
+            exit(1);
+        }
+
+        // another shard may have allocated the same chunk in the meantime
+        String* expected = NULL;
+        if (!__atomic_compare_exchange_n(&pool->chunks[k], &expected, chunk, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(chunk);
+        }
+        slot = intern_atom_slot(pool, atom, &k);
+    }
+    *slot = s;
+}
+
+static Intern_Shard* intern_shard_for(Intern_Pool* pool, String s) {
+    if (pool->shard_count == 1) return &pool->shards[0];
+    return &pool->shards[(uint32_t)(hash_string64(s, 0) >> 32) % INTERN_SHARD_COUNT];  // the hash behind hash_string, high bits since the maps use the low ones
+}
+
+Atom intern(Intern_Pool* pool, String s) {
+    Intern_Shard* shard = intern_shard_for(pool, s);
+    if (pool->thread_safe) pthread_mutex_lock(&shard->lock);
+
+    Atom* found = (Atom*)string_map_get(&shard->map, s);
+    Atom atom;
+    if (found) {
+        atom = *found;
+    }
+    else {
+        char* bytes = (char*)arena_push_aligned(&shard->arena, s.size + 1, 1);
+        memcpy(bytes, s.data, s.size);
+        bytes[s.size] = '\0';
+        String copy = (String){.data = bytes, .size = s.size};
+
+        atom = pool->thread_safe ? __atomic_fetch_add(&pool->count, 1, __ATOMIC_RELAXED) : pool->count++;
+        intern_set_atom(pool, atom, copy);
+        string_map_put(&shard->map, copy, &atom);
+    }
+
+    if (pool->thread_safe) pthread_mutex_unlock(&shard->lock);
+    return atom;
+}
+
+Atom intern_find(Intern_Pool* pool, String s) {
+    Intern_Shard* shard = intern_shard_for(pool, s);
+    if (pool->thread_safe) pthread_mutex_lock(&shard->lock);
+
+    Atom* found = (Atom*)string_map_get(&shard->map, s);
+    Atom atom = found ? *found : ATOM_NONE;
+
+    if (pool->thread_safe) pthread_mutex_unlock(&shard->lock);
+    return atom;
+}
+
+String atom_string(const Intern_Pool* pool, Atom atom) {
+    if (atom >= intern_count(pool)) return (String){.data = NULL, .size = 0};
+
+    int k;
+    String* slot = intern_atom_slot(pool, atom, &k);
+    return slot ? *slot : (String){.data = NULL, .size = 0};
+}
+
+uint32_t intern_count(const Intern_Pool* pool) {
+    return __atomic_load_n(&pool->count, __ATOMIC_RELAXED);
+}
+
+#endif // INTERN_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _INTERN
@@ -0,0 +1,234 @@
+#ifndef _LINE_READER
+#define _LINE_READER
+
+// streaming line reader with bounded memory, for files that do not fit in memory or arrive through a pipe
+// the file is read in chunks into two reusable buffers, a partial line at the end of a chunk is moved in front of the next one
+// with prefetch on a background thread reads the next chunk while the current one is being parsed
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "string_builder.h"
+
+#define LINE_READER_DEFAULT_CHUNK_SIZE (1 << 20)
+
+typedef struct {
+    char* memory;  // room for a carried partial line followed by the chunk
+    int filled;    // bytes read into the chunk, 0 at the end of the file, -1 on errors
+} Line_Reader_Buffer;
+
+typedef struct {
+    int fd;
+    bool owns_fd;
+    int chunk_size;
+    Line_Reader_Buffer buffers[2];
+    int current;
+    const char* cursor;  // next unread byte in the current buffer
+    const char* end;
+    bool eof;
+    bool long_line;      // a line longer than chunk_size was handed out in pieces
+    int error_code;      // 0 if no errors
+
+    bool prefetch;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;         // buffer the background thread should fill, -1 if none
+    bool quit;
+} Line_Reader;
+
+bool line_reader_open(Line_Reader* reader, const char* path, int chunk_size /* 0 for the default */, bool prefetch);
+void line_reader_init_fd(Line_Reader* reader, int fd, int chunk_size /* 0 for the default */, bool prefetch);
+// the line does not include the '\n' and stays valid until the next call, returns false at the end of the file or on errors
+bool line_reader_next(Line_Reader* reader, String* line);
+void line_reader_close(Line_Reader* reader);
+
+#ifdef LINE_READER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static void line_reader_fill(Line_Reader* reader, int index) {
+    Line_Reader_Buffer* buffer = &reader->buffers[index];
+    ssize_t n;
+    do {
+        n = read(reader->fd, buffer->memory + reader->chunk_size, reader->chunk_size);
+    } while (n < 0 && errno == EINTR);
+    buffer->filled = (int)n;
+}
+
+static void* line_reader_thread(void* arg) {
+    Line_Reader* reader = (Line_Reader*)arg;
+    pthread_mutex_lock(&reader->lock);
+    for (;;) {
+        while (reader->pending < 0 && !reader->quit) {
+            pthread_cond_wait(&reader->cond, &reader->lock);
+        }
+        if (reader->quit) break;
+
+        int index = reader->pending;
+        pthread_mutex_unlock(&reader->lock);
+        line_reader_fill(reader, index);
+        pthread_mutex_lock(&reader->lock);
+
+        reader->pending = -1;
+        pthread_cond_broadcast(&reader->cond);
+    }
+    pthread_mutex_unlock(&reader->lock);
+    return NULL;
+}
+
+static void line_reader_request(Line_Reader* reader, int index) {
+    pthread_mutex_lock(&reader->lock);
+    reader->pending = index;
+    pthread_cond_broadcast(&reader->cond);
+    pthread_mutex_unlock(&reader->lock);
+}
+
+static void line_reader_wait(Line_Reader* reader) {
+    pthread_mutex_lock(&reader->lock);
+    while (reader->pending >= 0) {
+        pthread_cond_wait(&reader->cond, &reader->lock);
+    }
+    pthread_mutex_unlock(&reader->lock);
+}
+
+void line_reader_init_fd(Line_Reader* reader, int fd, int chunk_size, bool prefetch) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = fd;
+    reader->chunk_size = chunk_size > 0 ? chunk_size : LINE_READER_DEFAULT_CHUNK_SIZE;
+    reader->pending = -1;
+
+    for (int i = 0; i < 2; i++) {
+        reader->buffers[i].memory = (char*)malloc(2 * (size_t)reader->chunk_size);
+        if (!reader->buffers[i].memory) {
+            fprintf(stderr, "Memory allocation failure creating a line reader with %d byte chunks\n", reader->chunk_size);
+            reader->error_code = 1;
+            reader->eof = true;
+            return;
+        }
+    }
+
+    // the first chunk is read right away, the second one in the background if prefetching
+    line_reader_fill(reader, 0);
+    Line_Reader_Buffer* first = &reader->buffers[0];
+    reader->cursor = first->memory + reader->chunk_size;
+    reader->end = reader->cursor + (first->filled > 0 ? first->filled : 0);
+    if (first->filled <= 0) {
+        reader->eof = true;
+        if (first->filled < 0) reader->error_code = 1;
+        return;
+    }
+
+    if (prefetch) {
+        pthread_mutex_init(&reader->lock, NULL);
+        pthread_cond_init(&reader->cond, NULL);
+        reader->prefetch = pthread_create(&reader->thread, NULL, line_reader_thread, reader) == 0;
+        if (reader->prefetch) {
+            line_reader_request(reader, 1);
+        }
+        else {
+            pthread_mutex_destroy(&reader->lock);
+            pthread_cond_destroy(&reader->cond);
+        }
+    }
+}
+
+bool line_reader_open(Line_Reader* reader, const char* path, int chunk_size, bool prefetch) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file %s\n", path);
+        memset(reader, 0, sizeof(*reader));
+        reader->fd = -1;
+        reader->error_code = 1;
+        reader->eof = true;
+        return false;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    line_reader_init_fd(reader, fd, chunk_size, prefetch);
+    reader->owns_fd = true;
+    return reader->error_code == 0;
+}
+
+bool line_reader_next(Line_Reader* reader, String* line) {
+    for (;;) {
+        int available = (int)(reader->end - reader->cursor);
+        const char* newline = available ? (const char*)memchr(reader->cursor, '\n', available) : NULL;
+        if (newline) {
+            *line = (String){.data = reader->cursor, .size = (int)(newline - reader->cursor)};
+            reader->cursor = newline + 1;
+            return true;
+        }
+
+        // the last line of a file without a trailing newline, or one that does not fit in the carry area
+        if ((reader->eof && available) || available >= reader->chunk_size) {
+            if (!reader->eof) reader->long_line = true;
+            *line = (String){.data = reader->cursor, .size = available};
+            reader->cursor = reader->end;
+            return true;
+        }
+        if (reader->eof) return false;
+
+        int next = 1 - reader->current;
+        if (reader->prefetch) {
+            line_reader_wait(reader);
+        }
+        else {
+            line_reader_fill(reader, next);
+        }
+
+        // move the partial line right in front of the new chunk so it stays contiguous
+        Line_Reader_Buffer* buffer = &reader->buffers[next];
+        char* chunk = buffer->memory + reader->chunk_size;
+        memcpy(chunk - available, reader->cursor, available);
+        reader->cursor = chunk - available;
+        reader->end = chunk + (buffer->filled > 0 ? buffer->filled : 0);
+        reader->current = next;
+
+        if (buffer->filled <= 0) {
+            reader->eof = true;
+            if (buffer->filled < 0) reader->error_code = 1;
+        }
+        else if (reader->prefetch) {
+            line_reader_request(reader, 1 - next);
+        }
+    }
+}
+
+void line_reader_close(Line_Reader* reader) {
+    if (reader->prefetch) {
+        pthread_mutex_lock(&reader->lock);
+        reader->quit = true;
+        pthread_cond_broadcast(&reader->cond);
+        pthread_mutex_unlock(&reader->lock);
+        pthread_join(reader->thread, NULL);
+        pthread_mutex_destroy(&reader->lock);
+        pthread_cond_destroy(&reader->cond);
+    }
+
+    if (reader->owns_fd && reader->fd >= 0) close(reader->fd);
+    free(reader->buffers[0].memory);
+    free(reader->buffers[1].memory);
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
+
+#endif // LINE_READER_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _LINE_READER
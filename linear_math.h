@@ -1,10 +1,18 @@
 #ifndef _LINEAR_MATH
 #define _LINEAR_MATH
 
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
 
-#define INDEX(r, c) (r * 4 +c)
+#define INDEX(r, c) ((r) * 4 + (c))  // mat3 rows are padded to 4 floats like the ones of mat4
 
 typedef struct {
     float x;
@@ -47,13 +55,14 @@ typedef enum {
     AXIS_X, AXIS_Y, AXIS_Z, AXIS_W
 } Axis;
 
-typedef union {
+// rows are padded to 4 floats and aligned so one load gets a row, the padding is kept at 0
+typedef union __attribute__((aligned(16))) {
     struct {
-        float m00, m01, m02;
-        float m10, m11, m12;
-        float m20, m21, m22;
+        float m00, m01, m02, pad0;
+        float m10, m11, m12, pad1;
+        float m20, m21, m22, pad2;
     };
-    float m[16];
+    float m[12];
 } mat3;
 
 mat3 mat3_identity();
@@ -69,7 +78,7 @@ mat3 mat3_transform_matrix(vec3 i, vec3 j, vec3 k);  // change of basis
 void mat3_rotate(mat3* m, float t, Axis axis);
 void mat3_print(mat3* m);
 
-typedef union {
+typedef union __attribute__((aligned(16))) {
     struct {
         float m00, m01, m02, m03;
         float m10, m11, m12, m13;
@@ -88,24 +97,107 @@ void mat4_rotate(mat4* m, float t, Axis axis);
 void mat4_ortho(mat4* m, float left, float right, float bottom, float top, float near, float far);
 void mat4_print(mat4* m);
 
+// unit quaternion for rotations, compose them with quat_multiply and turn the result into a matrix at the end
+typedef struct __attribute__((aligned(16))) {
+    float x, y, z;  // sin(t/2) * axis
+    float w;        // cos(t/2)
+} quat;
+
+quat quat_identity();
+quat quat_from_axis_angle(vec3 axis, float t);  // right handed rotation of t radians, the axis does not need to be unit length
+quat quat_multiply(quat q, quat r);  // rotates by r then by q, like mat3_multiply(dest, q, r)
+quat quat_conjugate(quat q);          // the inverse rotation
+quat quat_normalize(quat q);          // to undo the drift of long chains of multiplies
+vec3 quat_rotate(quat q, vec3 v);
+quat quat_nlerp(quat q, quat r, float t);  // both take the shortest path
+quat quat_slerp(quat q, quat r, float t);  // constant angular speed, nlerp is cheaper and close for small angles
+mat3 quat_to_mat3(quat q);
+mat4 quat_to_mat4(quat q);
+
+// structure of arrays, for running one operation over many vectors
+// the kernels go 8 vectors at a time with avx when the cpu has it (picked at runtime like in string_builder.h),
+// define LINEAR_MATH_NO_SIMD to always use the scalar loops
+// the destination of a batch operation grows to the count of the source and can be one of the arguments
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    int count;
+    int capacity;
+} vec3_soa;
+
+typedef struct {
+    float* x;
+    float* y;
+    int count;
+    int capacity;
+} vec2_soa;
+
+vec3_soa make_vec3_soa(int capacity);
+void vec3_soa_free(vec3_soa* a);
+void vec3_soa_reserve(vec3_soa* a, int capacity);  // keeps the first count vectors
+vec3 vec3_soa_get(const vec3_soa* a, int i);
+void vec3_soa_set(vec3_soa* a, int i, vec3 v);
+void vec3_soa_from_aos(vec3_soa* dst, const vec3* src, int count);
+void vec3_soa_to_aos(vec3* dst, const vec3_soa* src);
+
+void vec3_soa_add(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b);
+void vec3_soa_sub(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b);
+void vec3_soa_dot(float* dst, const vec3_soa* a, const vec3_soa* b);
+void vec3_soa_cross(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b);
+void vec3_soa_normalize(vec3_soa* dst, const vec3_soa* a);
+void vec3_soa_transform(vec3_soa* dst, const mat3* m, const vec3_soa* a);       // mat3_transform on every vector
+void vec3_soa_transform_mat4(vec3_soa* dst, const mat4* m, const vec3_soa* a);  // as points (w = 1), w of the result is dropped
+
+vec2_soa make_vec2_soa(int capacity);
+void vec2_soa_free(vec2_soa* a);
+void vec2_soa_reserve(vec2_soa* a, int capacity);
+vec2 vec2_soa_get(const vec2_soa* a, int i);
+void vec2_soa_set(vec2_soa* a, int i, vec2 v);
+void vec2_soa_from_aos(vec2_soa* dst, const vec2* src, int count);
+void vec2_soa_to_aos(vec2* dst, const vec2_soa* src);
+
+void vec2_soa_add(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b);
+void vec2_soa_sub(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b);
+void vec2_soa_dot(float* dst, const vec2_soa* a, const vec2_soa* b);
+void vec2_soa_normalize(vec2_soa* dst, const vec2_soa* a);
+void vec2_soa_transform(vec2_soa* dst, const mat3* m, const vec2_soa* a);  // as points (x, y, 1), the third coordinate is dropped
+
 #ifdef LINEAR_MATH_IMPLEMENTATION
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(LINEAR_MATH_NO_SIMD)
+#define LINEAR_MATH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef LINEAR_MATH_SIMD_X86
+// 0 scalar, 1 sse2, 2 avx, 3 avx with fma
+static int linear_math_cpu(void) {
+    static int cached_cpu_level = -1;
+    int cpu_level = __atomic_load_n(&cached_cpu_level, __ATOMIC_RELAXED);
+    if (cpu_level < 0) {
+        __builtin_cpu_init();
+        cpu_level = !__builtin_cpu_supports("sse2") ? 0 : !__builtin_cpu_supports("avx") ? 1 : __builtin_cpu_supports("fma") ? 3 : 2;
+        __atomic_store_n(&cached_cpu_level, cpu_level, __ATOMIC_RELAXED);
+    }
+    return cpu_level;
+}
+#endif  // LINEAR_MATH_SIMD_X86
+
 mat3 mat3_identity() {
     return (mat3) {
-        .m00 = 1, .m01 = 0, .m02 = 0,
-        .m10 = 0, .m11 = 1, .m12 = 0,
-        .m20 = 0, .m21 = 0, .m22 = 1,
+        .m00 = 1, .m01 = 0, .m02 = 0, .pad0 = 0,
+        .m10 = 0, .m11 = 1, .m12 = 0, .pad1 = 0,
+        .m20 = 0, .m21 = 0, .m22 = 1, .pad2 = 0,
     };
 }
 
 float mat3_get(mat3* m, int row, int col) {
-    float* c = (float*)m;
-    return c[row * 3 + col];
+    return m->m[INDEX(row, col)];
 }
 
 float* mat3_get_ref(mat3* m, int row, int col) {
-    float* c = (float*)m;
-    return &c[row * 3 + col];
+    return &m->m[INDEX(row, col)];
 }
 
 void mat3_transform(mat3* m, vec3* v) {
@@ -116,9 +208,9 @@ void mat3_transform(mat3* m, vec3* v) {
     };
 }
 
-// the dest and the arguments can be the same thanks to the copy
-void mat3_multiply(mat3* dest, mat3* m, mat3* n) {
+static void mat3_multiply_scalar(mat3* dest, mat3* m, mat3* n) {
     mat3 d;
+    memset(&d, 0, sizeof(d));
     for (int i = 0; i < 3; i++)
     {
         for (int j = 0; j < 3; j++)
@@ -135,9 +227,56 @@ void mat3_multiply(mat3* dest, mat3* m, mat3* n) {
     memcpy(dest, &d, sizeof(mat3));
 }
 
+#ifdef LINEAR_MATH_SIMD_X86
+
+// a row of the result is the rows of n scaled by the elements of the row of m, all of n is loaded before anything is stored
+#define LINEAR_MATH_BROADCAST(row, k) _mm_shuffle_ps(row, row, _MM_SHUFFLE(k, k, k, k))
+
+__attribute__((target("sse2")))
+static void mat3_multiply_sse2(mat3* dest, mat3* m, mat3* n) {
+    __m128 n0 = _mm_load_ps(n->m), n1 = _mm_load_ps(n->m + 4), n2 = _mm_load_ps(n->m + 8);
+    __m128 no_pad = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    for (int i = 0; i < 3; i++) {
+        __m128 row = _mm_load_ps(m->m + i * 4);
+        __m128 d = _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 0), n0);
+        d = _mm_add_ps(d, _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 1), n1));
+        d = _mm_add_ps(d, _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 2), n2));
+        _mm_store_ps(dest->m + i * 4, _mm_and_ps(d, no_pad));
+    }
+}
+
+__attribute__((target("avx,fma")))
+static void mat3_multiply_fma(mat3* dest, mat3* m, mat3* n) {
+    __m128 n0 = _mm_load_ps(n->m), n1 = _mm_load_ps(n->m + 4), n2 = _mm_load_ps(n->m + 8);
+    __m128 no_pad = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    for (int i = 0; i < 3; i++) {
+        __m128 row = _mm_load_ps(m->m + i * 4);
+        __m128 d = _mm_mul_ps(_mm_permute_ps(row, _MM_SHUFFLE(0, 0, 0, 0)), n0);
+        d = _mm_fmadd_ps(_mm_permute_ps(row, _MM_SHUFFLE(1, 1, 1, 1)), n1, d);
+        d = _mm_fmadd_ps(_mm_permute_ps(row, _MM_SHUFFLE(2, 2, 2, 2)), n2, d);
+        _mm_store_ps(dest->m + i * 4, _mm_and_ps(d, no_pad));
+    }
+}
+
+#endif  // LINEAR_MATH_SIMD_X86
+
+// the dest and the arguments can be the same
+// with fma the products are not rounded before the sums, so the result can differ from the other paths in the last bit
+// fma is picked because it is faster than sse2 in bench/matrix_bench.c, a little for chained products, a lot for independent ones
+void mat3_multiply(mat3* dest, mat3* m, mat3* n) {
+#ifdef LINEAR_MATH_SIMD_X86
+    int cpu = linear_math_cpu();
+    if (cpu >= 3) mat3_multiply_fma(dest, m, n);
+    else if (cpu >= 1) mat3_multiply_sse2(dest, m, n);
+    else mat3_multiply_scalar(dest, m, n);
+#else
+    mat3_multiply_scalar(dest, m, n);
+#endif
+}
+
 void mat3_axis_rotation_matrix(mat3* m, float t, Axis axis) {
-    float cosine = cos(t);
-    float sine   = sin(t);
+    float cosine = cosf(t);
+    float sine   = sinf(t);
 
     int r1, r2, c1, c2;
     if (axis == AXIS_X) {
@@ -163,40 +302,14 @@ void mat3_axis_rotation_matrix(mat3* m, float t, Axis axis) {
 
 mat3 mat3_transpose(mat3 m) {
     return (mat3) {
-        .m00 = m.m00, .m01 = m.m10, .m02 = m.m20,
-        .m10 = m.m01, .m11 = m.m11, .m12 = m.m21,
-        .m20 = m.m02, .m21 = m.m12, .m22 = m.m22,
+        .m00 = m.m00, .m01 = m.m10, .m02 = m.m20, .pad0 = 0,
+        .m10 = m.m01, .m11 = m.m11, .m12 = m.m21, .pad1 = 0,
+        .m20 = m.m02, .m21 = m.m12, .m22 = m.m22, .pad2 = 0,
     };
 }
 
 mat3 mat3_rotation_matrix(float t, vec3 rotation_axis) {
-    mat3 rot_matrix = mat3_identity();
-
-    // new basis
-    vec3 nx = rotation_axis;
-    vec3 ny = vec3_perpendicular(rotation_axis);
-    vec3 nz = vec3_cross(nx, ny);
-
-    // forward transform into the new basis
-    mat3 forward = mat3_transform_matrix(nx, ny, nz);
-    mat3_multiply(&rot_matrix, &rot_matrix, &forward);
-
-    float c = cos(t);
-    float s = sin(t);
-    mat3 local_rot_x = (mat3){
-        .m00 = 1, .m01 = 0, .m02 = 0,
-        .m10 = 0, .m11 = c, .m12 = -s,
-        .m20 = 0, .m21 = s, .m22 =  c,
-    };
-    mat3_multiply(&rot_matrix, &local_rot_x, &rot_matrix);
-
-    // backward transform back to the old basis
-
-    // since the transform is to an orthonormal basis, the matrix is orthogonal which means it's inverse is equal to it's transpose
-    mat3 backward = mat3_transpose(forward);
-    mat3_multiply(&rot_matrix, &backward, &rot_matrix);
-
-    return rot_matrix;
+    return quat_to_mat3(quat_from_axis_angle(rotation_axis, t));
 }
 
 void mat3_rotate(mat3* m, float t, Axis axis)
@@ -232,9 +345,9 @@ mat3 mat3_inverse(mat3 m, float det) {
 
 mat3 mat3_transform_matrix(vec3 i, vec3 j, vec3 k) {
     mat3 forward = (mat3) {
-        .m00 = i.x, .m01 = j.x, .m02 = k.x,
-        .m10 = i.y, .m11 = j.y, .m12 = k.y,
-        .m20 = i.z, .m21 = j.z, .m22 = k.z,
+        .m00 = i.x, .m01 = j.x, .m02 = k.x, .pad0 = 0,
+        .m10 = i.y, .m11 = j.y, .m12 = k.y, .pad1 = 0,
+        .m20 = i.z, .m21 = j.z, .m22 = k.z, .pad2 = 0,
     };
 
     return mat3_inverse(forward, mat3_det(forward));
@@ -266,7 +379,8 @@ float* mat4_get_ref(mat4* m, int row, int col) {
     return &c[row * 4 + col];
 }
 
-void mat4_multiply(mat4* dest, mat4* m, mat4* n) {
+static void mat4_multiply_scalar(mat4* dest, mat4* m, mat4* n) {
+    mat4 d;
     for (int i = 0; i < 4; i++)
     {
         for (int j = 0; j < 4; j++)
@@ -276,14 +390,66 @@ void mat4_multiply(mat4* dest, mat4* m, mat4* n) {
                 accum += m->m[INDEX(i, k)] * n->m[INDEX(k, j)];
             }
 
-            dest->m[INDEX(i, j)] = accum;
+            d.m[INDEX(i, j)] = accum;
         }
     }
+
+    memcpy(dest, &d, sizeof(mat4));
+}
+
+#ifdef LINEAR_MATH_SIMD_X86
+
+__attribute__((target("sse2")))
+static void mat4_multiply_sse2(mat4* dest, mat4* m, mat4* n) {
+    __m128 n0 = _mm_load_ps(n->m), n1 = _mm_load_ps(n->m + 4), n2 = _mm_load_ps(n->m + 8), n3 = _mm_load_ps(n->m + 12);
+    for (int i = 0; i < 4; i++) {
+        __m128 row = _mm_load_ps(m->m + i * 4);
+        __m128 d = _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 0), n0);
+        d = _mm_add_ps(d, _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 1), n1));
+        d = _mm_add_ps(d, _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 2), n2));
+        d = _mm_add_ps(d, _mm_mul_ps(LINEAR_MATH_BROADCAST(row, 3), n3));
+        _mm_store_ps(dest->m + i * 4, d);
+    }
+}
+
+// two rows of the result per register, the rows of n are repeated in both halves
+__attribute__((target("avx,fma")))
+static void mat4_multiply_fma(mat4* dest, mat4* m, mat4* n) {
+    __m256 n0 = _mm256_broadcast_ps((const __m128*)n->m), n1 = _mm256_broadcast_ps((const __m128*)(n->m + 4));
+    __m256 n2 = _mm256_broadcast_ps((const __m128*)(n->m + 8)), n3 = _mm256_broadcast_ps((const __m128*)(n->m + 12));
+    __m256 rows01 = _mm256_loadu_ps(m->m), rows23 = _mm256_loadu_ps(m->m + 8);
+    __m256 d01 = _mm256_mul_ps(_mm256_permute_ps(rows01, _MM_SHUFFLE(0, 0, 0, 0)), n0);
+    __m256 d23 = _mm256_mul_ps(_mm256_permute_ps(rows23, _MM_SHUFFLE(0, 0, 0, 0)), n0);
+    d01 = _mm256_fmadd_ps(_mm256_permute_ps(rows01, _MM_SHUFFLE(1, 1, 1, 1)), n1, d01);
+    d23 = _mm256_fmadd_ps(_mm256_permute_ps(rows23, _MM_SHUFFLE(1, 1, 1, 1)), n1, d23);
+    d01 = _mm256_fmadd_ps(_mm256_permute_ps(rows01, _MM_SHUFFLE(2, 2, 2, 2)), n2, d01);
+    d23 = _mm256_fmadd_ps(_mm256_permute_ps(rows23, _MM_SHUFFLE(2, 2, 2, 2)), n2, d23);
+    d01 = _mm256_fmadd_ps(_mm256_permute_ps(rows01, _MM_SHUFFLE(3, 3, 3, 3)), n3, d01);
+    d23 = _mm256_fmadd_ps(_mm256_permute_ps(rows23, _MM_SHUFFLE(3, 3, 3, 3)), n3, d23);
+    _mm256_storeu_ps(dest->m, d01);
+    _mm256_storeu_ps(dest->m + 8, d23);
+    _mm256_zeroupper();
+}
+
+#undef LINEAR_MATH_BROADCAST
+
+#endif  // LINEAR_MATH_SIMD_X86
+
+// the dest and the arguments can be the same, same rounding as mat3_multiply
+void mat4_multiply(mat4* dest, mat4* m, mat4* n) {
+#ifdef LINEAR_MATH_SIMD_X86
+    int cpu = linear_math_cpu();
+    if (cpu >= 3) mat4_multiply_fma(dest, m, n);
+    else if (cpu >= 1) mat4_multiply_sse2(dest, m, n);
+    else mat4_multiply_scalar(dest, m, n);
+#else
+    mat4_multiply_scalar(dest, m, n);
+#endif
 }
 
 void mat4_rotation_matrix(mat4* m, float t, Axis axis) {
-    float cosine = cos(t);
-    float sine   = sin(t);
+    float cosine = cosf(t);
+    float sine   = sinf(t);
 
     int r1, r2, c1, c2;
     if (axis == AXIS_X) {
@@ -348,6 +514,131 @@ void mat4_print(mat4* m) {
     printf("\n");
 }
 
+quat quat_identity() {
+    return (quat){0, 0, 0, 1};
+}
+
+quat quat_from_axis_angle(vec3 axis, float t) {
+    float length = sqrtf(dot3(axis, axis));
+    float s = sinf(t * 0.5f) / length;
+    return (quat){axis.x * s, axis.y * s, axis.z * s, cosf(t * 0.5f)};
+}
+
+quat quat_conjugate(quat q) {
+    return (quat){-q.x, -q.y, -q.z, q.w};
+}
+
+// x86_64 always has sse2, the single quaternion ones do not go through the runtime pick
+#if defined(LINEAR_MATH_SIMD_X86) && defined(__SSE2__)
+
+quat quat_multiply(quat q, quat r) {
+    __m128 a = _mm_load_ps(&q.x), b = _mm_load_ps(&r.x);
+    // each column of the product is a coordinate of q times r shuffled, with some signs flipped
+    __m128 d = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+    __m128 bx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3));  // w z y x
+    __m128 by = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));  // z w x y
+    __m128 bz = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));  // y x w z
+    bx = _mm_xor_ps(bx, _mm_castsi128_ps(_mm_set_epi32(INT32_MIN, 0, INT32_MIN, 0)));
+    by = _mm_xor_ps(by, _mm_castsi128_ps(_mm_set_epi32(INT32_MIN, INT32_MIN, 0, 0)));
+    bz = _mm_xor_ps(bz, _mm_castsi128_ps(_mm_set_epi32(INT32_MIN, 0, 0, INT32_MIN)));
+    d = _mm_add_ps(d, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), bx));
+    d = _mm_add_ps(d, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), by));
+    d = _mm_add_ps(d, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), bz));
+    quat result;
+    _mm_store_ps(&result.x, d);
+    return result;
+}
+
+quat quat_normalize(quat q) {
+    __m128 v = _mm_load_ps(&q.x);
+    __m128 d = _mm_mul_ps(v, v);
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+    quat result;
+    _mm_store_ps(&result.x, _mm_div_ps(v, _mm_sqrt_ps(d)));
+    return result;
+}
+
+#else
+
+quat quat_multiply(quat q, quat r) {
+    return (quat){
+        .x = q.w * r.x + q.x * r.w + q.y * r.z - q.z * r.y,
+        .y = q.w * r.y - q.x * r.z + q.y * r.w + q.z * r.x,
+        .z = q.w * r.z + q.x * r.y - q.y * r.x + q.z * r.w,
+        .w = q.w * r.w - q.x * r.x - q.y * r.y - q.z * r.z,
+    };
+}
+
+quat quat_normalize(quat q) {
+    float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return (quat){q.x / length, q.y / length, q.z / length, q.w / length};
+}
+
+#endif
+
+// v + 2w(u x v) + 2u x (u x v) with u the vector part, cheaper than building the matrix for a few vectors
+vec3 quat_rotate(quat q, vec3 v) {
+    vec3 u = {q.x, q.y, q.z};
+    vec3 t = vec3_cross(u, v);
+    t = (vec3){2 * t.x, 2 * t.y, 2 * t.z};
+    vec3 c = vec3_cross(u, t);
+    return (vec3){v.x + q.w * t.x + c.x, v.y + q.w * t.y + c.y, v.z + q.w * t.z + c.z};
+}
+
+static float quat_dot(quat q, quat r) {
+    return q.x * r.x + q.y * r.y + q.z * r.z + q.w * r.w;
+}
+
+quat quat_nlerp(quat q, quat r, float t) {
+    // q and -q are the same rotation, the one closer to q goes the short way
+    float s = quat_dot(q, r) < 0 ? -t : t;
+    quat result = {
+        q.x + (r.x * s - q.x * t),
+        q.y + (r.y * s - q.y * t),
+        q.z + (r.z * s - q.z * t),
+        q.w + (r.w * s - q.w * t),
+    };
+    return quat_normalize(result);
+}
+
+quat quat_slerp(quat q, quat r, float t) {
+    float cosine = quat_dot(q, r);
+    if (cosine < 0) {
+        r = (quat){-r.x, -r.y, -r.z, -r.w};
+        cosine = -cosine;
+    }
+    // sin of the angle gets too small to divide by, and the arc is a line anyway
+    if (cosine > 0.9995f) return quat_nlerp(q, r, t);
+
+    float angle = acosf(cosine);
+    float sine = sinf(angle);
+    float a = sinf((1 - t) * angle) / sine;
+    float b = sinf(t * angle) / sine;
+    return (quat){a * q.x + b * r.x, a * q.y + b * r.y, a * q.z + b * r.z, a * q.w + b * r.w};
+}
+
+mat3 quat_to_mat3(quat q) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return (mat3) {
+        .m00 = 1 - 2 * (yy + zz), .m01 = 2 * (xy - wz),     .m02 = 2 * (xz + wy), .pad0 = 0,
+        .m10 = 2 * (xy + wz),     .m11 = 1 - 2 * (xx + zz), .m12 = 2 * (yz - wx), .pad1 = 0,
+        .m20 = 2 * (xz - wy),     .m21 = 2 * (yz + wx),     .m22 = 1 - 2 * (xx + yy), .pad2 = 0,
+    };
+}
+
+mat4 quat_to_mat4(quat q) {
+    mat3 r = quat_to_mat3(q);
+    return (mat4) {
+        .m00 = r.m00, .m01 = r.m01, .m02 = r.m02, .m03 = 0,
+        .m10 = r.m10, .m11 = r.m11, .m12 = r.m12, .m13 = 0,
+        .m20 = r.m20, .m21 = r.m21, .m22 = r.m22, .m23 = 0,
+        .m30 = 0,     .m31 = 0,     .m32 = 0,     .m33 = 1,
+    };
+}
+
 ivec2 to_ivec2(vec2 v) {
     return (ivec2){(int)v.x, (int)v.y};
 }
@@ -418,10 +709,527 @@ float vec2_det(vec2 c1, vec2 c2) {
 vec2 to_v2(vec3 v) {return (vec2) {.x = v.x, .y = v.y};}
 
 vec2 vec2_normalize(vec2 v) {
-    float len = sqrt(v.x * v.x + v.y * v.y);
+    float len = sqrtf(v.x * v.x + v.y * v.y);
     return (vec2){v.x/len, v.y/len};
 }
 
+
+// each array starts on a cache line, one allocation for all of them
+static float* linear_math_alloc_arrays(int capacity, int arrays, int* rounded) {
+    *rounded = (capacity + 15) & ~15;
+    size_t size = (size_t)*rounded * arrays * sizeof(float);
+    float* memory = (float*)aligned_alloc(64, size ? size : 64);
+    if (!memory) {
+        fprintf(stderr, "Memory allocation failure creating arrays of %d vectors\n", capacity);
+        exit(1);
+    }
+    return memory;
+}
+
+vec3_soa make_vec3_soa(int capacity) {
+    vec3_soa a;
+    memset(&a, 0, sizeof(a));
+    a.x = linear_math_alloc_arrays(capacity, 3, &a.capacity);
+    a.y = a.x + a.capacity;
+    a.z = a.y + a.capacity;
+    return a;
+}
+
+void vec3_soa_free(vec3_soa* a) {
+    free(a->x);
+    memset(a, 0, sizeof(*a));
+}
+
+void vec3_soa_reserve(vec3_soa* a, int capacity) {
+    if (capacity <= a->capacity) return;
+    vec3_soa grown = make_vec3_soa(capacity > a->capacity * 2 ? capacity : a->capacity * 2);
+    if (a->count) {
+        memcpy(grown.x, a->x, a->count * sizeof(float));
+        memcpy(grown.y, a->y, a->count * sizeof(float));
+        memcpy(grown.z, a->z, a->count * sizeof(float));
+    }
+    grown.count = a->count;
+    free(a->x);
+    *a = grown;
+}
+
+vec3 vec3_soa_get(const vec3_soa* a, int i) {
+    return (vec3){a->x[i], a->y[i], a->z[i]};
+}
+
+void vec3_soa_set(vec3_soa* a, int i, vec3 v) {
+    a->x[i] = v.x;
+    a->y[i] = v.y;
+    a->z[i] = v.z;
+}
+
+vec2_soa make_vec2_soa(int capacity) {
+    vec2_soa a;
+    memset(&a, 0, sizeof(a));
+    a.x = linear_math_alloc_arrays(capacity, 2, &a.capacity);
+    a.y = a.x + a.capacity;
+    return a;
+}
+
+void vec2_soa_free(vec2_soa* a) {
+    free(a->x);
+    memset(a, 0, sizeof(*a));
+}
+
+void vec2_soa_reserve(vec2_soa* a, int capacity) {
+    if (capacity <= a->capacity) return;
+    vec2_soa grown = make_vec2_soa(capacity > a->capacity * 2 ? capacity : a->capacity * 2);
+    if (a->count) {
+        memcpy(grown.x, a->x, a->count * sizeof(float));
+        memcpy(grown.y, a->y, a->count * sizeof(float));
+    }
+    grown.count = a->count;
+    free(a->x);
+    *a = grown;
+}
+
+vec2 vec2_soa_get(const vec2_soa* a, int i) {
+    return (vec2){a->x[i], a->y[i]};
+}
+
+void vec2_soa_set(vec2_soa* a, int i, vec2 v) {
+    a->x[i] = v.x;
+    a->y[i] = v.y;
+}
+
+// sizes the destination for count vectors, when it is also an argument it is already big enough and does not move
+static void vec3_soa_prepare(vec3_soa* dst, int count) {
+    vec3_soa_reserve(dst, count);
+    dst->count = count;
+}
+
+static void vec2_soa_prepare(vec2_soa* dst, int count) {
+    vec2_soa_reserve(dst, count);
+    dst->count = count;
+}
+
+static int linear_math_batch_count(int a, int b) {
+    if (a != b) fprintf(stderr, "Batch operation on arrays of %d and %d vectors, using the first %d\n", a, b, a < b ? a : b);
+    return a < b ? a : b;
+}
+
+// 4 vectors at a time with sse shuffles when the target has sse2 (x86_64 always does)
+void vec3_soa_from_aos(vec3_soa* dst, const vec3* src, int count) {
+    vec3_soa_prepare(dst, count);
+    int i = 0;
+#if defined(LINEAR_MATH_SIMD_X86) && defined(__SSE2__)
+    const float* f = (const float*)src;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(f + i * 3);      // x0 y0 z0 x1
+        __m128 b = _mm_loadu_ps(f + i * 3 + 4);  // y1 z1 x2 y2
+        __m128 c = _mm_loadu_ps(f + i * 3 + 8);  // z2 x3 y3 z3
+        __m128 bc_x = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2));
+        __m128 ab_y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1));
+        __m128 bc_y = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3));
+        __m128 ab_z = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2));
+        __m128 cc_z = _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0));
+        _mm_storeu_ps(dst->x + i, _mm_shuffle_ps(a, bc_x, _MM_SHUFFLE(2, 0, 3, 0)));
+        _mm_storeu_ps(dst->y + i, _mm_shuffle_ps(ab_y, bc_y, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(dst->z + i, _mm_shuffle_ps(ab_z, cc_z, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#endif
+    for (; i < count; i++) {
+        vec3_soa_set(dst, i, src[i]);
+    }
+}
+
+void vec3_soa_to_aos(vec3* dst, const vec3_soa* src) {
+    int i = 0;
+#if defined(LINEAR_MATH_SIMD_X86) && defined(__SSE2__)
+    float* f = (float*)dst;
+    for (; i + 4 <= src->count; i += 4) {
+        __m128 x = _mm_loadu_ps(src->x + i), y = _mm_loadu_ps(src->y + i), z = _mm_loadu_ps(src->z + i);
+        __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        _mm_storeu_ps(f + i * 3, a);
+        _mm_storeu_ps(f + i * 3 + 4, b);
+        _mm_storeu_ps(f + i * 3 + 8, c);
+    }
+#endif
+    for (; i < src->count; i++) {
+        dst[i] = vec3_soa_get(src, i);
+    }
+}
+
+void vec2_soa_from_aos(vec2_soa* dst, const vec2* src, int count) {
+    vec2_soa_prepare(dst, count);
+    int i = 0;
+#if defined(LINEAR_MATH_SIMD_X86) && defined(__SSE2__)
+    const float* f = (const float*)src;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(f + i * 2), b = _mm_loadu_ps(f + i * 2 + 4);
+        _mm_storeu_ps(dst->x + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(dst->y + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; i < count; i++) {
+        vec2_soa_set(dst, i, src[i]);
+    }
+}
+
+void vec2_soa_to_aos(vec2* dst, const vec2_soa* src) {
+    int i = 0;
+#if defined(LINEAR_MATH_SIMD_X86) && defined(__SSE2__)
+    float* f = (float*)dst;
+    for (; i + 4 <= src->count; i += 4) {
+        __m128 x = _mm_loadu_ps(src->x + i), y = _mm_loadu_ps(src->y + i);
+        _mm_storeu_ps(f + i * 2, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(f + i * 2 + 4, _mm_unpackhi_ps(x, y));
+    }
+#endif
+    for (; i < src->count; i++) {
+        dst[i] = vec2_soa_get(src, i);
+    }
+}
+
+// the scalar loops start at the first vector the avx loop left, the avx ones clear the upper halves before handing over
+static void vec3_soa_add_from(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst->x[i] = a->x[i] + b->x[i];
+        dst->y[i] = a->y[i] + b->y[i];
+        dst->z[i] = a->z[i] + b->z[i];
+    }
+}
+
+static void vec3_soa_sub_from(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst->x[i] = a->x[i] - b->x[i];
+        dst->y[i] = a->y[i] - b->y[i];
+        dst->z[i] = a->z[i] - b->z[i];
+    }
+}
+
+static void vec3_soa_dot_from(float* dst, const vec3_soa* a, const vec3_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst[i] = a->x[i] * b->x[i] + a->y[i] * b->y[i] + a->z[i] * b->z[i];
+    }
+}
+
+static void vec3_soa_cross_from(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        float x = a->y[i] * b->z[i] - a->z[i] * b->y[i];
+        float y = a->z[i] * b->x[i] - a->x[i] * b->z[i];
+        float z = a->x[i] * b->y[i] - a->y[i] * b->x[i];
+        dst->x[i] = x;
+        dst->y[i] = y;
+        dst->z[i] = z;
+    }
+}
+
+static void vec3_soa_normalize_from(vec3_soa* dst, const vec3_soa* a, int i, int count) {
+    for (; i < count; i++) {
+        float length = sqrtf(a->x[i] * a->x[i] + a->y[i] * a->y[i] + a->z[i] * a->z[i]);
+        dst->x[i] = a->x[i] / length;
+        dst->y[i] = a->y[i] / length;
+        dst->z[i] = a->z[i] / length;
+    }
+}
+
+static void vec3_soa_transform_from(vec3_soa* dst, const mat3* m, const vec3_soa* a, int i, int count) {
+    for (; i < count; i++) {
+        float x = a->x[i], y = a->y[i], z = a->z[i];
+        dst->x[i] = m->m00 * x + m->m01 * y + m->m02 * z;
+        dst->y[i] = m->m10 * x + m->m11 * y + m->m12 * z;
+        dst->z[i] = m->m20 * x + m->m21 * y + m->m22 * z;
+    }
+}
+
+static void vec3_soa_transform_mat4_from(vec3_soa* dst, const mat4* m, const vec3_soa* a, int i, int count) {
+    for (; i < count; i++) {
+        float x = a->x[i], y = a->y[i], z = a->z[i];
+        dst->x[i] = m->m00 * x + m->m01 * y + m->m02 * z + m->m03;
+        dst->y[i] = m->m10 * x + m->m11 * y + m->m12 * z + m->m13;
+        dst->z[i] = m->m20 * x + m->m21 * y + m->m22 * z + m->m23;
+    }
+}
+
+static void vec2_soa_add_from(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst->x[i] = a->x[i] + b->x[i];
+        dst->y[i] = a->y[i] + b->y[i];
+    }
+}
+
+static void vec2_soa_sub_from(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst->x[i] = a->x[i] - b->x[i];
+        dst->y[i] = a->y[i] - b->y[i];
+    }
+}
+
+static void vec2_soa_dot_from(float* dst, const vec2_soa* a, const vec2_soa* b, int i, int count) {
+    for (; i < count; i++) {
+        dst[i] = a->x[i] * b->x[i] + a->y[i] * b->y[i];
+    }
+}
+
+static void vec2_soa_normalize_from(vec2_soa* dst, const vec2_soa* a, int i, int count) {
+    for (; i < count; i++) {
+        float length = sqrtf(a->x[i] * a->x[i] + a->y[i] * a->y[i]);
+        dst->x[i] = a->x[i] / length;
+        dst->y[i] = a->y[i] / length;
+    }
+}
+
+static void vec2_soa_transform_from(vec2_soa* dst, const mat3* m, const vec2_soa* a, int i, int count) {
+    for (; i < count; i++) {
+        float x = a->x[i], y = a->y[i];
+        dst->x[i] = m->m00 * x + m->m01 * y + m->m02;
+        dst->y[i] = m->m10 * x + m->m11 * y + m->m12;
+    }
+}
+
+#ifdef LINEAR_MATH_SIMD_X86
+
+#define LINEAR_MATH_LOAD(array) _mm256_loadu_ps((array) + i)
+#define LINEAR_MATH_STORE(array, v) _mm256_storeu_ps((array) + i, v)
+
+__attribute__((target("avx")))
+static void vec3_soa_add_avx(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        LINEAR_MATH_STORE(dst->x, _mm256_add_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x)));
+        LINEAR_MATH_STORE(dst->y, _mm256_add_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y)));
+        LINEAR_MATH_STORE(dst->z, _mm256_add_ps(LINEAR_MATH_LOAD(a->z), LINEAR_MATH_LOAD(b->z)));
+    }
+    _mm256_zeroupper();
+    vec3_soa_add_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_sub_avx(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        LINEAR_MATH_STORE(dst->x, _mm256_sub_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x)));
+        LINEAR_MATH_STORE(dst->y, _mm256_sub_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y)));
+        LINEAR_MATH_STORE(dst->z, _mm256_sub_ps(LINEAR_MATH_LOAD(a->z), LINEAR_MATH_LOAD(b->z)));
+    }
+    _mm256_zeroupper();
+    vec3_soa_sub_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_dot_avx(float* dst, const vec3_soa* a, const vec3_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 d = _mm256_mul_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x));
+        d = _mm256_add_ps(d, _mm256_mul_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y)));
+        d = _mm256_add_ps(d, _mm256_mul_ps(LINEAR_MATH_LOAD(a->z), LINEAR_MATH_LOAD(b->z)));
+        LINEAR_MATH_STORE(dst, d);
+    }
+    _mm256_zeroupper();
+    vec3_soa_dot_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_cross_avx(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 ax = LINEAR_MATH_LOAD(a->x), ay = LINEAR_MATH_LOAD(a->y), az = LINEAR_MATH_LOAD(a->z);
+        __m256 bx = LINEAR_MATH_LOAD(b->x), by = LINEAR_MATH_LOAD(b->y), bz = LINEAR_MATH_LOAD(b->z);
+        LINEAR_MATH_STORE(dst->x, _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+        LINEAR_MATH_STORE(dst->y, _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+        LINEAR_MATH_STORE(dst->z, _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+    }
+    _mm256_zeroupper();
+    vec3_soa_cross_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_normalize_avx(vec3_soa* dst, const vec3_soa* a, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LINEAR_MATH_LOAD(a->x), y = LINEAR_MATH_LOAD(a->y), z = LINEAR_MATH_LOAD(a->z);
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+        __m256 length = _mm256_sqrt_ps(d);
+        LINEAR_MATH_STORE(dst->x, _mm256_div_ps(x, length));
+        LINEAR_MATH_STORE(dst->y, _mm256_div_ps(y, length));
+        LINEAR_MATH_STORE(dst->z, _mm256_div_ps(z, length));
+    }
+    _mm256_zeroupper();
+    vec3_soa_normalize_from(dst, a, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_transform_avx(vec3_soa* dst, const mat3* m, const vec3_soa* a, int count) {
+    __m256 m00 = _mm256_set1_ps(m->m00), m01 = _mm256_set1_ps(m->m01), m02 = _mm256_set1_ps(m->m02);
+    __m256 m10 = _mm256_set1_ps(m->m10), m11 = _mm256_set1_ps(m->m11), m12 = _mm256_set1_ps(m->m12);
+    __m256 m20 = _mm256_set1_ps(m->m20), m21 = _mm256_set1_ps(m->m21), m22 = _mm256_set1_ps(m->m22);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LINEAR_MATH_LOAD(a->x), y = LINEAR_MATH_LOAD(a->y), z = LINEAR_MATH_LOAD(a->z);
+        LINEAR_MATH_STORE(dst->x, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), _mm256_mul_ps(m02, z)));
+        LINEAR_MATH_STORE(dst->y, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m12, z)));
+        LINEAR_MATH_STORE(dst->z, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, x), _mm256_mul_ps(m21, y)), _mm256_mul_ps(m22, z)));
+    }
+    _mm256_zeroupper();
+    vec3_soa_transform_from(dst, m, a, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec3_soa_transform_mat4_avx(vec3_soa* dst, const mat4* m, const vec3_soa* a, int count) {
+    __m256 m00 = _mm256_set1_ps(m->m00), m01 = _mm256_set1_ps(m->m01), m02 = _mm256_set1_ps(m->m02), m03 = _mm256_set1_ps(m->m03);
+    __m256 m10 = _mm256_set1_ps(m->m10), m11 = _mm256_set1_ps(m->m11), m12 = _mm256_set1_ps(m->m12), m13 = _mm256_set1_ps(m->m13);
+    __m256 m20 = _mm256_set1_ps(m->m20), m21 = _mm256_set1_ps(m->m21), m22 = _mm256_set1_ps(m->m22), m23 = _mm256_set1_ps(m->m23);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LINEAR_MATH_LOAD(a->x), y = LINEAR_MATH_LOAD(a->y), z = LINEAR_MATH_LOAD(a->z);
+        LINEAR_MATH_STORE(dst->x, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), _mm256_mul_ps(m02, z)), m03));
+        LINEAR_MATH_STORE(dst->y, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m12, z)), m13));
+        LINEAR_MATH_STORE(dst->z, _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m20, x), _mm256_mul_ps(m21, y)), _mm256_mul_ps(m22, z)), m23));
+    }
+    _mm256_zeroupper();
+    vec3_soa_transform_mat4_from(dst, m, a, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec2_soa_add_avx(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        LINEAR_MATH_STORE(dst->x, _mm256_add_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x)));
+        LINEAR_MATH_STORE(dst->y, _mm256_add_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y)));
+    }
+    _mm256_zeroupper();
+    vec2_soa_add_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec2_soa_sub_avx(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        LINEAR_MATH_STORE(dst->x, _mm256_sub_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x)));
+        LINEAR_MATH_STORE(dst->y, _mm256_sub_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y)));
+    }
+    _mm256_zeroupper();
+    vec2_soa_sub_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec2_soa_dot_avx(float* dst, const vec2_soa* a, const vec2_soa* b, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 d = _mm256_mul_ps(LINEAR_MATH_LOAD(a->x), LINEAR_MATH_LOAD(b->x));
+        LINEAR_MATH_STORE(dst, _mm256_add_ps(d, _mm256_mul_ps(LINEAR_MATH_LOAD(a->y), LINEAR_MATH_LOAD(b->y))));
+    }
+    _mm256_zeroupper();
+    vec2_soa_dot_from(dst, a, b, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec2_soa_normalize_avx(vec2_soa* dst, const vec2_soa* a, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LINEAR_MATH_LOAD(a->x), y = LINEAR_MATH_LOAD(a->y);
+        __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)));
+        LINEAR_MATH_STORE(dst->x, _mm256_div_ps(x, length));
+        LINEAR_MATH_STORE(dst->y, _mm256_div_ps(y, length));
+    }
+    _mm256_zeroupper();
+    vec2_soa_normalize_from(dst, a, i, count);
+}
+
+__attribute__((target("avx")))
+static void vec2_soa_transform_avx(vec2_soa* dst, const mat3* m, const vec2_soa* a, int count) {
+    __m256 m00 = _mm256_set1_ps(m->m00), m01 = _mm256_set1_ps(m->m01), m02 = _mm256_set1_ps(m->m02);
+    __m256 m10 = _mm256_set1_ps(m->m10), m11 = _mm256_set1_ps(m->m11), m12 = _mm256_set1_ps(m->m12);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = LINEAR_MATH_LOAD(a->x), y = LINEAR_MATH_LOAD(a->y);
+        LINEAR_MATH_STORE(dst->x, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), m02));
+        LINEAR_MATH_STORE(dst->y, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), m12));
+    }
+    _mm256_zeroupper();
+    vec2_soa_transform_from(dst, m, a, i, count);
+}
+
+#undef LINEAR_MATH_LOAD
+#undef LINEAR_MATH_STORE
+
+#endif  // LINEAR_MATH_SIMD_X86
+
+#ifdef LINEAR_MATH_SIMD_X86
+#define LINEAR_MATH_DISPATCH(avx_call, scalar_call) do { if (linear_math_cpu() >= 2) avx_call; else scalar_call; } while (0)
+#else
+#define LINEAR_MATH_DISPATCH(avx_call, scalar_call) scalar_call
+#endif
+
+void vec3_soa_add(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    vec3_soa_prepare(dst, count);
+    LINEAR_MATH_DISPATCH(vec3_soa_add_avx(dst, a, b, count), vec3_soa_add_from(dst, a, b, 0, count));
+}
+
+void vec3_soa_sub(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    vec3_soa_prepare(dst, count);
+    LINEAR_MATH_DISPATCH(vec3_soa_sub_avx(dst, a, b, count), vec3_soa_sub_from(dst, a, b, 0, count));
+}
+
+void vec3_soa_dot(float* dst, const vec3_soa* a, const vec3_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    LINEAR_MATH_DISPATCH(vec3_soa_dot_avx(dst, a, b, count), vec3_soa_dot_from(dst, a, b, 0, count));
+}
+
+void vec3_soa_cross(vec3_soa* dst, const vec3_soa* a, const vec3_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    vec3_soa_prepare(dst, count);
+    LINEAR_MATH_DISPATCH(vec3_soa_cross_avx(dst, a, b, count), vec3_soa_cross_from(dst, a, b, 0, count));
+}
+
+void vec3_soa_normalize(vec3_soa* dst, const vec3_soa* a) {
+    vec3_soa_prepare(dst, a->count);
+    LINEAR_MATH_DISPATCH(vec3_soa_normalize_avx(dst, a, a->count), vec3_soa_normalize_from(dst, a, 0, a->count));
+}
+
+void vec3_soa_transform(vec3_soa* dst, const mat3* m, const vec3_soa* a) {
+    vec3_soa_prepare(dst, a->count);
+    LINEAR_MATH_DISPATCH(vec3_soa_transform_avx(dst, m, a, a->count), vec3_soa_transform_from(dst, m, a, 0, a->count));
+}
+
+void vec3_soa_transform_mat4(vec3_soa* dst, const mat4* m, const vec3_soa* a) {
+    vec3_soa_prepare(dst, a->count);
+    LINEAR_MATH_DISPATCH(vec3_soa_transform_mat4_avx(dst, m, a, a->count), vec3_soa_transform_mat4_from(dst, m, a, 0, a->count));
+}
+
+void vec2_soa_add(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    vec2_soa_prepare(dst, count);
+    LINEAR_MATH_DISPATCH(vec2_soa_add_avx(dst, a, b, count), vec2_soa_add_from(dst, a, b, 0, count));
+}
+
+void vec2_soa_sub(vec2_soa* dst, const vec2_soa* a, const vec2_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    vec2_soa_prepare(dst, count);
+    LINEAR_MATH_DISPATCH(vec2_soa_sub_avx(dst, a, b, count), vec2_soa_sub_from(dst, a, b, 0, count));
+}
+
+void vec2_soa_dot(float* dst, const vec2_soa* a, const vec2_soa* b) {
+    int count = linear_math_batch_count(a->count, b->count);
+    LINEAR_MATH_DISPATCH(vec2_soa_dot_avx(dst, a, b, count), vec2_soa_dot_from(dst, a, b, 0, count));
+}
+
+void vec2_soa_normalize(vec2_soa* dst, const vec2_soa* a) {
+    vec2_soa_prepare(dst, a->count);
+    LINEAR_MATH_DISPATCH(vec2_soa_normalize_avx(dst, a, a->count), vec2_soa_normalize_from(dst, a, 0, a->count));
+}
+
+void vec2_soa_transform(vec2_soa* dst, const mat3* m, const vec2_soa* a) {
+    vec2_soa_prepare(dst, a->count);
+    LINEAR_MATH_DISPATCH(vec2_soa_transform_avx(dst, m, a, a->count), vec2_soa_transform_from(dst, m, a, 0, a->count));
+}
+
+#undef LINEAR_MATH_DISPATCH
+
 #endif // LINEAR_MATH_IMPLEMENTATION
 
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
 #endif // _LINEAR_MATH
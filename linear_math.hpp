@@ -0,0 +1,299 @@
+#ifndef _LINEAR_MATH_HPP
+#define _LINEAR_MATH_HPP
+
+// C++17 layer over linear_math.h, the C functions and types stay available next to it
+// Vec<N, T> and Mat<R, C, T> have the layout of vec2, vec3, mat3 and mat4 (mat3 rows padded to 4), from_c and to_c convert
+// arithmetic on vectors builds expression templates that are evaluated in one pass when assigned to a Vec,
+// so a + b * s - c makes no temporaries; expressions hold references to their Vec operands, do not keep them in auto variables
+// everything without a sqrt or a trigonometric function is constexpr, matrix multiplies outside of constant evaluation
+// go to the simd mat3_multiply and mat4_multiply, so the program needs LINEAR_MATH_IMPLEMENTATION compiled in somewhere
+
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+
+#include "linear_math.h"
+
+namespace linear_math {
+
+template <typename E, int N, typename T>
+struct Vec_Expr {
+    constexpr T operator[](int i) const { return static_cast<const E&>(*this)[i]; }
+};
+
+template <int N, typename T = float>
+struct Vec : Vec_Expr<Vec<N, T>, N, T> {
+    static_assert(N > 0, "a vector needs at least one element");
+    T data[N];
+
+    constexpr Vec() : data{} {}
+
+    template <typename... Args, typename = std::enable_if_t<sizeof...(Args) == N && (std::is_arithmetic_v<Args> && ...)>>
+    constexpr Vec(Args... args) : data{static_cast<T>(args)...} {}
+
+    // evaluates the whole expression, one element at a time
+    template <typename E>
+    constexpr Vec(const Vec_Expr<E, N, T>& e) : data{} {
+        for (int i = 0; i < N; i++) data[i] = e[i];
+    }
+
+    // through a copy, elements of a matrix product depend on all of the operand, which can be this one
+    template <typename E>
+    constexpr Vec& operator=(const Vec_Expr<E, N, T>& e) {
+        Vec result(e);
+        for (int i = 0; i < N; i++) data[i] = result.data[i];
+        return *this;
+    }
+
+    constexpr T operator[](int i) const { return data[i]; }
+    constexpr T& operator[](int i) { return data[i]; }
+
+    constexpr T x() const { return data[0]; }
+    constexpr T y() const { static_assert(N >= 2, "no y in a 1d vector"); return data[1]; }
+    constexpr T z() const { static_assert(N >= 3, "no z in a 2d vector"); return data[2]; }
+    constexpr T w() const { static_assert(N >= 4, "no w in a 3d vector"); return data[3]; }
+};
+
+using Vec2 = Vec<2, float>;
+using Vec3 = Vec<3, float>;
+using Vec4 = Vec<4, float>;
+
+// a Vec is kept by reference, anything else is a small expression node kept by value
+template <typename E>
+struct Expr_Operand { using type = const E; };
+
+template <int N, typename T>
+struct Expr_Operand<Vec<N, T>> { using type = const Vec<N, T>&; };
+
+template <typename L, typename R, typename Op, int N, typename T>
+struct Vec_Binary : Vec_Expr<Vec_Binary<L, R, Op, N, T>, N, T> {
+    typename Expr_Operand<L>::type l;
+    typename Expr_Operand<R>::type r;
+
+    constexpr Vec_Binary(const L& l, const R& r) : l(l), r(r) {}
+    constexpr T operator[](int i) const { return Op::apply(l[i], r[i]); }
+};
+
+template <typename E, typename Op, int N, typename T>
+struct Vec_Scalar : Vec_Expr<Vec_Scalar<E, Op, N, T>, N, T> {
+    typename Expr_Operand<E>::type e;
+    T s;
+
+    constexpr Vec_Scalar(const E& e, T s) : e(e), s(s) {}
+    constexpr T operator[](int i) const { return Op::apply(e[i], s); }
+};
+
+struct Op_Add { template <typename T> static constexpr T apply(T a, T b) { return a + b; } };
+struct Op_Sub { template <typename T> static constexpr T apply(T a, T b) { return a - b; } };
+struct Op_Mul { template <typename T> static constexpr T apply(T a, T b) { return a * b; } };
+struct Op_Div { template <typename T> static constexpr T apply(T a, T b) { return a / b; } };
+
+template <typename L, typename R, int N, typename T>
+constexpr Vec_Binary<L, R, Op_Add, N, T> operator+(const Vec_Expr<L, N, T>& l, const Vec_Expr<R, N, T>& r) {
+    return {static_cast<const L&>(l), static_cast<const R&>(r)};
+}
+
+template <typename L, typename R, int N, typename T>
+constexpr Vec_Binary<L, R, Op_Sub, N, T> operator-(const Vec_Expr<L, N, T>& l, const Vec_Expr<R, N, T>& r) {
+    return {static_cast<const L&>(l), static_cast<const R&>(r)};
+}
+
+// element wise
+template <typename L, typename R, int N, typename T>
+constexpr Vec_Binary<L, R, Op_Mul, N, T> operator*(const Vec_Expr<L, N, T>& l, const Vec_Expr<R, N, T>& r) {
+    return {static_cast<const L&>(l), static_cast<const R&>(r)};
+}
+
+// the scalar is its own parameter converted to T, so v * 2 and v / 2.0 work on float vectors
+template <typename E, int N, typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vec_Scalar<E, Op_Mul, N, T> operator*(const Vec_Expr<E, N, T>& e, S s) {
+    return {static_cast<const E&>(e), static_cast<T>(s)};
+}
+
+template <typename E, int N, typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vec_Scalar<E, Op_Mul, N, T> operator*(S s, const Vec_Expr<E, N, T>& e) {
+    return {static_cast<const E&>(e), static_cast<T>(s)};
+}
+
+template <typename E, int N, typename T, typename S, typename = std::enable_if_t<std::is_arithmetic_v<S>>>
+constexpr Vec_Scalar<E, Op_Div, N, T> operator/(const Vec_Expr<E, N, T>& e, S s) {
+    return {static_cast<const E&>(e), static_cast<T>(s)};
+}
+
+template <typename E, int N, typename T>
+constexpr Vec_Scalar<E, Op_Mul, N, T> operator-(const Vec_Expr<E, N, T>& e) {
+    return {static_cast<const E&>(e), T(-1)};
+}
+
+template <typename L, typename R, int N, typename T>
+constexpr T dot(const Vec_Expr<L, N, T>& l, const Vec_Expr<R, N, T>& r) {
+    T sum = l[0] * r[0];
+    for (int i = 1; i < N; i++) sum += l[i] * r[i];
+    return sum;
+}
+
+// each element reads two of each operand, so they are evaluated once up front
+template <typename L, typename R, typename T>
+constexpr Vec<3, T> cross(const Vec_Expr<L, 3, T>& l, const Vec_Expr<R, 3, T>& r) {
+    Vec<3, T> a(l), b(r);
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+template <typename E, int N, typename T>
+T length(const Vec_Expr<E, N, T>& e) {
+    return sqrt(dot(e, e));
+}
+
+template <typename E, int N, typename T>
+Vec<N, T> normalize(const Vec_Expr<E, N, T>& e) {
+    Vec<N, T> v(e);
+    return v / length(v);
+}
+
+// rows padded to 4 elements when there are 3 columns, like mat3, the padding stays 0
+template <int R, int C, typename T = float>
+struct alignas(((C == 3 ? 4 : C) * sizeof(T)) % 16 == 0 ? 16 : alignof(T)) Mat {
+    static constexpr int stride = C == 3 ? 4 : C;
+    T data[R][stride];
+
+    constexpr Mat() : data{} {}
+
+    static constexpr Mat identity() {
+        Mat m;
+        for (int i = 0; i < (R < C ? R : C); i++) m.data[i][i] = 1;
+        return m;
+    }
+
+    constexpr T operator()(int r, int c) const { return data[r][c]; }
+    constexpr T& operator()(int r, int c) { return data[r][c]; }
+
+    constexpr Vec<C, T> row(int r) const {
+        Vec<C, T> v;
+        for (int c = 0; c < C; c++) v[c] = data[r][c];
+        return v;
+    }
+};
+
+using Mat3 = Mat<3, 3, float>;
+using Mat4 = Mat<4, 4, float>;
+
+static_assert(sizeof(Vec2) == sizeof(vec2) && alignof(Vec2) == alignof(vec2), "Vec2 is not laid out like vec2");
+static_assert(sizeof(Vec3) == sizeof(vec3) && alignof(Vec3) == alignof(vec3), "Vec3 is not laid out like vec3");
+static_assert(sizeof(Mat3) == sizeof(mat3) && alignof(Mat3) == alignof(mat3), "Mat3 is not laid out like mat3");
+static_assert(sizeof(Mat4) == sizeof(mat4) && alignof(Mat4) == alignof(mat4), "Mat4 is not laid out like mat4");
+
+constexpr Vec2 from_c(vec2 v) { return {v.x, v.y}; }
+constexpr Vec3 from_c(vec3 v) { return {v.x, v.y, v.z}; }
+constexpr vec2 to_c(const Vec2& v) { return {v[0], v[1]}; }
+constexpr vec3 to_c(const Vec3& v) { return {v[0], v[1], v[2]}; }
+
+// same bytes, so a copy
+inline Mat3 from_c(const mat3& m) { Mat3 r; memcpy(r.data, &m, sizeof(r)); return r; }
+inline Mat4 from_c(const mat4& m) { Mat4 r; memcpy(r.data, &m, sizeof(r)); return r; }
+inline mat3 to_c(const Mat3& m) { mat3 r; memcpy(&r, m.data, sizeof(r)); return r; }
+inline mat4 to_c(const Mat4& m) { mat4 r; memcpy(&r, m.data, sizeof(r)); return r; }
+
+template <int R, int K, int C, typename T>
+constexpr Mat<R, C, T> operator*(const Mat<R, K, T>& a, const Mat<K, C, T>& b) {
+    if constexpr (std::is_same_v<T, float> && R == K && K == C && (R == 3 || R == 4)) {
+        if (!__builtin_is_constant_evaluated()) {
+            auto dest = to_c(a), n = to_c(b);
+            if constexpr (R == 3) mat3_multiply(&dest, &dest, &n);
+            else mat4_multiply(&dest, &dest, &n);
+            return from_c(dest);
+        }
+    }
+
+    Mat<R, C, T> d;
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < C; j++) {
+            T accum = 0;
+            for (int k = 0; k < K; k++) accum += a.data[i][k] * b.data[k][j];
+            d.data[i][j] = accum;
+        }
+    }
+    return d;
+}
+
+// the vector is evaluated into the node so each of its elements is computed once
+template <int R, int C, typename T>
+struct Mat_Vec : Vec_Expr<Mat_Vec<R, C, T>, R, T> {
+    const Mat<R, C, T>& m;
+    Vec<C, T> v;
+
+    template <typename E>
+    constexpr Mat_Vec(const Mat<R, C, T>& m, const Vec_Expr<E, C, T>& v) : m(m), v(v) {}
+
+    constexpr T operator[](int i) const {
+        T sum = m.data[i][0] * v[0];
+        for (int k = 1; k < C; k++) sum += m.data[i][k] * v[k];
+        return sum;
+    }
+};
+
+template <int R, int C, typename T, typename E>
+constexpr Mat_Vec<R, C, T> operator*(const Mat<R, C, T>& m, const Vec_Expr<E, C, T>& v) {
+    return {m, v};
+}
+
+template <int R, int C, typename T>
+constexpr Mat<C, R, T> transpose(const Mat<R, C, T>& m) {
+    Mat<C, R, T> t;
+    for (int i = 0; i < R; i++) {
+        for (int j = 0; j < C; j++) t.data[j][i] = m.data[i][j];
+    }
+    return t;
+}
+
+// the point (x, y, z, 1) through a 4x4 matrix, w is dropped
+template <typename E, typename T>
+constexpr Vec<3, T> transform_point(const Mat<4, 4, T>& m, const Vec_Expr<E, 3, T>& p) {
+    Vec<3, T> v(p);
+    return {m.data[0][0] * v[0] + m.data[0][1] * v[1] + m.data[0][2] * v[2] + m.data[0][3],
+            m.data[1][0] * v[0] + m.data[1][1] * v[1] + m.data[1][2] * v[2] + m.data[1][3],
+            m.data[2][0] * v[0] + m.data[2][1] * v[1] + m.data[2][2] * v[2] + m.data[2][3]};
+}
+
+// same matrix as mat4_ortho
+template <typename T = float>
+constexpr Mat<4, 4, T> ortho(T left, T right, T bottom, T top, T near, T far) {
+    Mat<4, 4, T> m;
+    m.data[0][0] = T(2) / (right - left);
+    m.data[0][3] = -(right + left) / (right - left);
+    m.data[1][1] = T(2) / (top - bottom);
+    m.data[1][3] = -(top + bottom) / (top - bottom);
+    m.data[2][2] = T(2) / (near - far);
+    m.data[2][3] = -(far + near) / (far - near);
+    m.data[3][3] = 1;
+    return m;
+}
+
+template <typename E, typename T>
+constexpr Mat<4, 4, T> translation(const Vec_Expr<E, 3, T>& offset) {
+    Mat<4, 4, T> m = Mat<4, 4, T>::identity();
+    for (int i = 0; i < 3; i++) m.data[i][3] = offset[i];
+    return m;
+}
+
+template <int N, typename T, typename E>
+constexpr Mat<N, N, T> scaling(const Vec_Expr<E, N, T>& factors) {
+    Mat<N, N, T> m;
+    for (int i = 0; i < N; i++) m.data[i][i] = factors[i];
+    return m;
+}
+
+// same matrix as quat_to_mat3, without the trigonometry it can be built at compile time from a known quaternion
+constexpr Mat3 rotation(const quat& q) {
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    Mat3 m;
+    m.data[0][0] = 1 - 2 * (yy + zz); m.data[0][1] = 2 * (xy - wz);     m.data[0][2] = 2 * (xz + wy);
+    m.data[1][0] = 2 * (xy + wz);     m.data[1][1] = 1 - 2 * (xx + zz); m.data[1][2] = 2 * (yz - wx);
+    m.data[2][0] = 2 * (xz - wy);     m.data[2][1] = 2 * (yz + wx);     m.data[2][2] = 1 - 2 * (xx + yy);
+    return m;
+}
+
+} // namespace linear_math
+
+#endif // _LINEAR_MATH_HPP
@@ -1,6 +1,19 @@
 #ifndef _LOG_H
 #define _LOG_H
 
+// standalone, LOG_IMPLEMENTATION does not need the implementation of any other header of the library
+
+// the implementation uses posix (nanosleep, clock_gettime, O_CLOEXEC, ...) which strict iso modes hide,
+// like in utility.h this only helps when no system header came before
+
+#if defined(LOG_IMPLEMENTATION) && defined(__STRICT_ANSI__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
 typedef enum {
     LOG_LEVEL_INFO,
     LOG_LEVEL_WARN,
@@ -9,57 +22,1164 @@ typedef enum {
 
 void log_log(Log_Level level, char const * const msg, ...);
 
-#ifndef LOG_SILENCE
+// asynchronous mode, log_log formats into a slot of a lock free ring buffer and returns
+// a background thread drains the ring in batches and writes each batch with a single call
+typedef enum {
+    LOG_FULL_DROP,            // drop the message
+    LOG_FULL_BLOCK,           // wait for the writer thread to make room
+    LOG_FULL_COUNT_AND_DROP,  // drop the message, the writer reports how many were dropped
+} Log_Full_Policy;
+
+typedef struct {
+    int capacity;  // messages the ring holds, rounded up to a power of two, 0 for the default
+    Log_Full_Policy full_policy;
+    // NULL to write text to stderr, otherwise the messages go unformatted to this file, see log_decode
+    const char* binary_path;
+} Log_Async_Config;
+
+#define LOG_MESSAGE_SIZE 1024  // longer messages are truncated
+#define LOG_ASYNC_DEFAULT_CAPACITY 4096
+#define LOG_MAX_ARGS 16
+
+bool log_async_start(Log_Async_Config config);
+void log_async_stop(void);  // drains the ring and joins the writer thread, no other thread may be logging
+// writes out the messages in the ring up to the first one another thread is still writing, usable from any thread
+// (e.g. before exiting), messages behind an unfinished one, even of calls that returned, are left to the writer thread
+void log_flush(void);
+// for crash handlers, only async signal safe calls: writes the messages left in the ring as text with write(2)
+// to the file sink or stderr (also with a binary_path), the LOG_*F ones as their format without the arguments
+// the ring is guarded by an atomic flag, not a mutex, this does nothing if another drain holds it
+// (the writer thread in the middle of a batch, e.g. when it is the thread that crashed)
+void log_flush_from_signal(void);
+uint64_t log_dropped_count(void);
+
+// file sink, text goes to a file instead of stderr without colours
+// in asynchronous mode messages are batched, each batch is a single write from the writer thread,
+// which also does the rotation and the syncs so producers never wait for them
+// otherwise each message is its own writev on the calling thread, which rotates and syncs when it is due
+// while holding the sink's lock, other threads logging at that moment wait for it
+typedef struct {
+    const char* path;
+    int64_t max_bytes;  // rotate once the file has grown past this, 0 for no limit
+    int max_seconds;    // rotate once the file has been written to for this long, 0 for no limit
+    int keep;           // rotated files kept as path.1 (newest) to path.keep, 0 to drop them
+    int sync_ms;        // fdatasync at most this often, 0 to leave it to the system
+} Log_File_Config;
+
+bool log_file_open(Log_File_Config config);  // appends if the file exists
+void log_file_close(void);                   // back to stderr
+
+// deferred formatting, the LOG_*F macros keep a static site per call with the format
+// in asynchronous mode the call only copies the raw arguments into the ring (strings by value),
+// the writer thread formats them or, with a binary_path, writes the site id and the argument bytes for log_decode
+// calls whose format is not a string literal still work, they are formatted on the spot like log_log
+typedef struct {
+    const char* format;  // a string literal, NULL if the call's format is not one
+    Log_Level level;
+    const char* file;
+    int line;
+    uint32_t per_second;     // messages let through per second, 0 for no limit
+    uint32_t id;             // 0 until the first call
+    int arg_count;           // -1 if the format cannot be recorded raw (%n, wide strings, too many arguments)
+    uint8_t arg_kinds[LOG_MAX_ARGS];
+    int32_t arg_precisions[LOG_MAX_ARGS];  // of %s arguments, -1 for none, -2 when it is the '*' argument before
+    uint32_t written_epoch;  // binary file the site was last described in, writer thread only
+
+    int64_t window;          // second the counts below belong to
+    uint32_t window_count;
+    uint32_t suppressed;     // reported when the site is next called in a later second
+} Log_Site;
+
+void log_log_site(Log_Site* site, const char* msg, ...);
+// turns a binary log into text, the file has to come from a machine with the same byte order and long double
+bool log_decode(FILE* in, FILE* out);
+
+// messages below the runtime level are skipped before their arguments are evaluated
+extern int log_level_threshold;
+void log_set_level(Log_Level level);
 
-#define LOG_INFO(msg)  log_log(LOG_LEVEL_INFO, msg)
-#define LOG_WARN(msg)  log_log(LOG_LEVEL_WARN, msg)
-#define LOG_ERROR(msg) log_log(LOG_LEVEL_ERROR , msg)
+// calls below LOG_MIN_LEVEL are compiled out: 0 info, 1 warnings, 2 errors, 3 nothing (same as LOG_SILENCE)
+#ifdef LOG_SILENCE
+#undef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 3
+#endif // LOG_SILENCE
 
-#define LOG_INFOF(msg, ...)  log_log(LOG_LEVEL_INFO, msg, __VA_ARGS__)
-#define LOG_WARNF(msg, ...)  log_log(LOG_LEVEL_WARN, msg, __VA_ARGS__)
-#define LOG_ERRORF(msg, ...) log_log(LOG_LEVEL_ERROR , msg, __VA_ARGS__)
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif // LOG_MIN_LEVEL
 
-#else // LOG_SILENCE
+#define LOG_LEVEL_ON(level_) ((int)(level_) >= __atomic_load_n(&log_level_threshold, __ATOMIC_RELAXED))
+// the site only keeps the format if it is a literal, __builtin_constant_p is allowed in static initializers
+#define LOG_FORMAT_OF(msg, ...) (__builtin_constant_p(msg) ? (msg) : NULL)
 
-#define LOG_INFO(about, msg) ((void)0)
-#define LOG_WARN(about, msg) ((void)0)
-#define LOG_ERROR(about, msg) ((void)0)
+#define LOG_TEXT_CALL(level_, msg) do { \
+        if (LOG_LEVEL_ON(level_)) log_log(level_, msg); \
+    } while (0)
 
-#define LOG_INFOF(about, msg, ...) ((void)0)
-#define LOG_WARNF(about, msg, ...) ((void)0)
-#define LOG_ERRORF(about, msg, ...) ((void)0)
+#define LOG_SITE_CALL(level_, per_second_, ...) do { \
+        if (LOG_LEVEL_ON(level_)) { \
+            static Log_Site log_site_ = { \
+                .format = LOG_FORMAT_OF(__VA_ARGS__, 0), \
+                .level = level_, \
+                .file = __FILE__, \
+                .line = __LINE__, \
+                .per_second = per_second_, \
+            }; \
+            log_log_site(&log_site_, __VA_ARGS__); \
+        } \
+    } while (0)
 
-#endif  // LOG_SILENCE
+// LOG_*F_LIMIT(per_second, msg, ...) lets at most per_second messages of the call through every second,
+// the number of suppressed ones is logged just before the call's next message in a later second,
+// a call that stays quiet afterwards never reports them
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_INFO(msg)                    LOG_TEXT_CALL(LOG_LEVEL_INFO, msg)
+#define LOG_INFOF(...)                   LOG_SITE_CALL(LOG_LEVEL_INFO, 0, __VA_ARGS__)
+#define LOG_INFOF_LIMIT(per_second, ...) LOG_SITE_CALL(LOG_LEVEL_INFO, per_second, __VA_ARGS__)
+#else
+#define LOG_INFO(...)       ((void)0)
+#define LOG_INFOF(...)      ((void)0)
+#define LOG_INFOF_LIMIT(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define LOG_WARN(msg)                    LOG_TEXT_CALL(LOG_LEVEL_WARN, msg)
+#define LOG_WARNF(...)                   LOG_SITE_CALL(LOG_LEVEL_WARN, 0, __VA_ARGS__)
+#define LOG_WARNF_LIMIT(per_second, ...) LOG_SITE_CALL(LOG_LEVEL_WARN, per_second, __VA_ARGS__)
+#else
+#define LOG_WARN(...)       ((void)0)
+#define LOG_WARNF(...)      ((void)0)
+#define LOG_WARNF_LIMIT(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= 2
+#define LOG_ERROR(msg)                    LOG_TEXT_CALL(LOG_LEVEL_ERROR, msg)
+#define LOG_ERRORF(...)                   LOG_SITE_CALL(LOG_LEVEL_ERROR, 0, __VA_ARGS__)
+#define LOG_ERRORF_LIMIT(per_second, ...) LOG_SITE_CALL(LOG_LEVEL_ERROR, per_second, __VA_ARGS__)
+#else
+#define LOG_ERROR(...)       ((void)0)
+#define LOG_ERRORF(...)      ((void)0)
+#define LOG_ERRORF_LIMIT(...) ((void)0)
+#endif
 
 #ifdef LOG_IMPLEMENTATION
 
-#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
 #define ANSI_END \033[0m
 #define ANSI_RED \033[31;1;1m
 
+static const char* log_level_prefix(Log_Level level) {
+    switch (level) {
+    case LOG_LEVEL_INFO:  return "\033[32;1;1m[INFO]:\033[0m ";
+    case LOG_LEVEL_WARN:  return "\033[33;1;1m[WARNING]:\033[0m ";
+    case LOG_LEVEL_ERROR: return "\033[31;1;1m[ERROR]:\033[0m ";
+    }
+    return "";
+}
+
+static const char* log_level_plain_prefix(Log_Level level) {
+    switch (level) {
+    case LOG_LEVEL_INFO:  return "[INFO]: ";
+    case LOG_LEVEL_WARN:  return "[WARNING]: ";
+    case LOG_LEVEL_ERROR: return "[ERROR]: ";
+    }
+    return "";
+}
+
+// raw arguments, integers and pointers are widened to 8 bytes, strings are a u16 length and the bytes
+typedef enum {
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LONG_LONG,
+    LOG_ARG_INTMAX,
+    LOG_ARG_SIZE,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LONG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER,
+} Log_Arg_Kind;
+
+typedef struct {
+    int length;  // of the conversion including the '%'
+    int stars;   // '*' width and precision arguments taken before the value
+    int kind;    // Log_Arg_Kind, -1 for "%%"
+    int precision;  // -1 for none, -2 for ".*"
+} Log_Spec;
+
+#define LOG_SPEC_MAX_LENGTH 32
+
+// parses the conversion starting at the '%', false if it cannot be recorded raw
+static bool log_parse_spec(const char* format, Log_Spec* spec) {
+    const char* p = format + 1;
+    spec->stars = 0;
+    spec->kind = -1;
+    spec->precision = -1;
+    if (*p == '%') {
+        spec->length = 2;
+        return true;
+    }
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        spec->precision = 0;
+        if (*p == '*') {
+            spec->stars++;
+            spec->precision = -2;
+            p++;
+        }
+        for (; *p >= '0' && *p <= '9'; p++) {
+            if (spec->precision >= 0 && spec->precision < LOG_MESSAGE_SIZE) spec->precision = spec->precision * 10 + (*p - '0');
+        }
+    }
+
+    int kind = LOG_ARG_INT;
+    switch (*p) {
+    case 'h': p++; if (*p == 'h') p++; break;
+    case 'l': p++; kind = LOG_ARG_LONG; if (*p == 'l') { p++; kind = LOG_ARG_LONG_LONG; } break;
+    case 'j': p++; kind = LOG_ARG_INTMAX; break;
+    case 'z': p++; kind = LOG_ARG_SIZE; break;
+    case 't': p++; kind = LOG_ARG_PTRDIFF; break;
+    case 'L': p++; kind = LOG_ARG_LONG_DOUBLE; break;
+    }
+
+    switch (*p++) {
+    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        if (kind == LOG_ARG_LONG_DOUBLE) return false;
+        break;
+    case 'c':
+        if (kind != LOG_ARG_INT) return false;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        if (kind != LOG_ARG_LONG_DOUBLE) kind = LOG_ARG_DOUBLE;
+        break;
+    case 's':
+        if (kind != LOG_ARG_INT) return false;
+        kind = LOG_ARG_STRING;
+        break;
+    case 'p':
+        kind = LOG_ARG_POINTER;
+        break;
+    default:
+        return false;
+    }
+
+    spec->length = (int)(p - format);
+    spec->kind = kind;
+    return spec->length < LOG_SPEC_MAX_LENGTH;
+}
+
+// argument kinds and string precisions of a whole format in call order, -1 if it cannot be recorded raw
+static int log_parse_format(const char* format, uint8_t kinds[LOG_MAX_ARGS], int32_t precisions[LOG_MAX_ARGS]) {
+    int count = 0;
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') continue;
+
+        Log_Spec spec;
+        if (!log_parse_spec(p, &spec)) return -1;
+        if (spec.kind >= 0) {
+            if (count + spec.stars + 1 > LOG_MAX_ARGS) return -1;
+            for (int i = 0; i < spec.stars; i++) {
+                precisions[count] = -1;
+                kinds[count++] = LOG_ARG_INT;
+            }
+            precisions[count] = spec.precision;
+            kinds[count++] = (uint8_t)spec.kind;
+        }
+        p += spec.length - 1;
+    }
+    return count;
+}
+
+// copies the arguments of a site into out, strings are cut so everything fits in capacity
+static int log_record_args(const Log_Site* site, unsigned char* out, int capacity, va_list args) {
+    int used = 0;
+    int64_t previous = -1;  // a '*' precision is the int argument right before the string
+    for (int i = 0; i < site->arg_count; i++) {
+        int64_t integer = 0;
+        switch (site->arg_kinds[i]) {
+        case LOG_ARG_INT:       integer = va_arg(args, int); break;
+        case LOG_ARG_LONG:      integer = va_arg(args, long); break;
+        case LOG_ARG_LONG_LONG: integer = va_arg(args, long long); break;
+        case LOG_ARG_INTMAX:    integer = (int64_t)va_arg(args, intmax_t); break;
+        case LOG_ARG_SIZE:      integer = (int64_t)va_arg(args, size_t); break;
+        case LOG_ARG_PTRDIFF:   integer = (int64_t)va_arg(args, ptrdiff_t); break;
+        case LOG_ARG_POINTER:   integer = (int64_t)(uintptr_t)va_arg(args, void*); break;
+        case LOG_ARG_DOUBLE: {
+            double value = va_arg(args, double);
+            memcpy(out + used, &value, sizeof(value));
+            used += sizeof(value);
+            continue;
+        }
+        case LOG_ARG_LONG_DOUBLE: {
+            long double value = va_arg(args, long double);
+            memcpy(out + used, &value, sizeof(value));
+            used += sizeof(value);
+            continue;
+        }
+        case LOG_ARG_STRING: {
+            const char* s = va_arg(args, const char*);
+            if (!s) s = "(null)";
+            // keep room for the fixed size arguments that follow
+            int room = capacity - used - 2 - (site->arg_count - i - 1) * (int)sizeof(long double);
+            // with a precision the argument does not have to be terminated, never read past it
+            int precision = site->arg_precisions[i];
+            if (precision == -2) precision = previous >= 0 && previous < room ? (int)previous : -1;
+            if (precision >= 0 && precision < room) room = precision;
+            int length = 0;
+            while (length < room && s[length]) length++;
+            uint16_t length16 = (uint16_t)length;
+            memcpy(out + used, &length16, sizeof(length16));
+            memcpy(out + used + 2, s, length);
+            used += 2 + length;
+            continue;
+        }
+        }
+        memcpy(out + used, &integer, sizeof(integer));
+        used += sizeof(integer);
+        previous = integer;
+    }
+    return used;
+}
+
+static bool log_read_arg(const unsigned char* args, int args_size, int* offset, void* value, int size) {
+    if (*offset + size > args_size) return false;
+    memcpy(value, args + *offset, size);
+    *offset += size;
+    return true;
+}
+
+// formats recorded arguments into out, returns the length without the terminator
+static int log_format_args(const char* format, const unsigned char* args, int args_size, char* out, int out_size) {
+    int length = 0;
+    int offset = 0;
+    const char* p = format;
+
+    while (*p && length < out_size - 1) {
+        if (*p != '%') {
+            out[length++] = *p++;
+            continue;
+        }
+
+        Log_Spec spec;
+        if (!log_parse_spec(p, &spec)) break;
+        if (spec.kind < 0) {
+            out[length++] = '%';
+            p += spec.length;
+            continue;
+        }
+
+        char conversion[LOG_SPEC_MAX_LENGTH];
+        memcpy(conversion, p, spec.length);
+        conversion[spec.length] = '\0';
+        p += spec.length;
+
+        int stars[2] = {0, 0};
+        for (int i = 0; i < spec.stars; i++) {
+            int64_t star;
+            if (!log_read_arg(args, args_size, &offset, &star, sizeof(star))) goto done;
+            stars[i] = (int)star;
+        }
+
+        char* dst = out + length;
+        size_t room = (size_t)(out_size - length);
+        int n = 0;
+
+#define LOG_FORMAT_VALUE(value)                                                      \
+        n = spec.stars == 0 ? snprintf(dst, room, conversion, value) :               \
+            spec.stars == 1 ? snprintf(dst, room, conversion, stars[0], value) :     \
+                              snprintf(dst, room, conversion, stars[0], stars[1], value)
+
+        if (spec.kind == LOG_ARG_STRING) {
+            uint16_t string_length;
+            if (!log_read_arg(args, args_size, &offset, &string_length, sizeof(string_length))) break;
+            if (offset + string_length > args_size) break;
+            char text[LOG_MESSAGE_SIZE];
+            int copied = string_length < sizeof(text) - 1 ? string_length : (int)sizeof(text) - 1;
+            memcpy(text, args + offset, copied);
+            text[copied] = '\0';
+            offset += string_length;
+            LOG_FORMAT_VALUE(text);
+        }
+        else if (spec.kind == LOG_ARG_DOUBLE) {
+            double value;
+            if (!log_read_arg(args, args_size, &offset, &value, sizeof(value))) break;
+            LOG_FORMAT_VALUE(value);
+        }
+        else if (spec.kind == LOG_ARG_LONG_DOUBLE) {
+            long double value;
+            if (!log_read_arg(args, args_size, &offset, &value, sizeof(value))) break;
+            LOG_FORMAT_VALUE(value);
+        }
+        else {
+            int64_t value;
+            if (!log_read_arg(args, args_size, &offset, &value, sizeof(value))) break;
+            switch (spec.kind) {
+            case LOG_ARG_INT:       LOG_FORMAT_VALUE((int)value); break;
+            case LOG_ARG_LONG:      LOG_FORMAT_VALUE((long)value); break;
+            case LOG_ARG_LONG_LONG: LOG_FORMAT_VALUE((long long)value); break;
+            case LOG_ARG_INTMAX:    LOG_FORMAT_VALUE((intmax_t)value); break;
+            case LOG_ARG_SIZE:      LOG_FORMAT_VALUE((size_t)value); break;
+            case LOG_ARG_PTRDIFF:   LOG_FORMAT_VALUE((ptrdiff_t)value); break;
+            case LOG_ARG_POINTER:   LOG_FORMAT_VALUE((void*)(uintptr_t)value); break;
+            }
+        }
+
+#undef LOG_FORMAT_VALUE
+
+        if (n > 0) length += (size_t)n < room ? n : (int)room - 1;
+    }
+
+done:
+    out[length] = '\0';
+    return length;
+}
+
+typedef struct {
+    uint64_t sequence;  // equal to the enqueue position when free, one past it when it holds a message
+    Log_Level level;
+    Log_Site* site;     // NULL if message holds formatted text, otherwise the recorded arguments
+    int length;
+    char message[LOG_MESSAGE_SIZE];
+} Log_Slot;
+
+// binary log records, all integers in native byte order
+#define LOG_BINARY_MAGIC "LOGB\x01\0\0\0"
+enum {
+    LOG_RECORD_SITE = 1,  // u32 id, u8 level, u32 line, u16 format length, format, u16 file length, file
+    LOG_RECORD_EVENT,     // u32 site id, u16 size, recorded arguments
+    LOG_RECORD_TEXT,      // u8 level, u16 length, text
+};
+
+// bounded multi producer queue (Vyukov), single consumer holding draining
+static struct {
+    Log_Slot* slots;
+    uint64_t mask;
+    Log_Full_Policy full_policy;
+    bool running;  // log_log goes through the ring
+    FILE* binary;  // NULL when writing text to stderr
+    uint32_t epoch;
+
+    char pad0[64];
+    uint64_t enqueue_pos;
+    char pad1[64];
+    uint64_t dequeue_pos;
+    uint64_t dropped;
+    uint64_t dropped_reported;
+
+    bool draining;  // taken with an atomic exchange, a signal handler can only try it
+    pthread_t writer;
+    bool stop;
+} log_async;
+
+static pthread_mutex_t log_site_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t log_site_count;
+
+static struct {
+    int fd;  // -1 while writing to stderr
+    char* path;
+    Log_File_Config config;
+    int64_t size;
+    int64_t opened_ms;
+    int64_t synced_ms;
+    pthread_mutex_t lock;
+} log_file = {.fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER};
+
+static int log_stderr_colors = -1;  // unknown until the first message
+
+static int64_t log_now_ms(void) {
+    struct timespec now;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#elif defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    timespec_get(&now, TIME_UTC);
+#endif
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// colours only for a terminal
+static const char* log_prefix(Log_Level level) {
+    if (__atomic_load_n(&log_file.fd, __ATOMIC_RELAXED) >= 0) return log_level_plain_prefix(level);
+
+    int colors = __atomic_load_n(&log_stderr_colors, __ATOMIC_RELAXED);
+    if (colors < 0) {
+        colors = isatty(STDERR_FILENO);
+        __atomic_store_n(&log_stderr_colors, colors, __ATOMIC_RELAXED);
+    }
+    return colors ? log_level_prefix(level) : log_level_plain_prefix(level);
+}
+
+// without O_CLOEXEC the descriptor is inherited by exec'd children, which only keeps the file open longer
+#ifdef O_CLOEXEC
+#define LOG_FILE_CLOEXEC O_CLOEXEC
+#else
+#define LOG_FILE_CLOEXEC 0
+#endif
+
+static int log_file_open_fd(const char* path, bool truncate) {
+    return open(path, O_WRONLY | O_CREAT | O_APPEND | LOG_FILE_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+}
+
+// shifts path.1 ... path.keep up by one and starts a new file, log_file.lock has to be held
+static void log_file_rotate(int64_t now_ms) {
+    int keep = log_file.config.keep;
+    size_t name_size = strlen(log_file.path) + 16;
+    char* from = (char*)malloc(name_size);
+    char* to = (char*)malloc(name_size);
+    if (from && to) {
+        for (int i = keep - 1; i >= 1; i--) {
+            snprintf(from, name_size, "%s.%d", log_file.path, i);
+            snprintf(to, name_size, "%s.%d", log_file.path, i + 1);
+            rename(from, to);
+        }
+        if (keep > 0) {
+            snprintf(to, name_size, "%s.1", log_file.path);
+            rename(log_file.path, to);
+        }
+    }
+    free(from);
+    free(to);
+
+    if (log_file.config.sync_ms > 0) fdatasync(log_file.fd);
+    close(log_file.fd);
+    log_file.fd = log_file_open_fd(log_file.path, true);
+    if (log_file.fd < 0) fprintf(stderr, "Could not reopen log file %s, logging to stderr\n", log_file.path);
+    log_file.size = 0;
+    log_file.opened_ms = now_ms;
+}
+
+// writes all of iov to the file sink, false if there is none
+static bool log_file_write(struct iovec* iov, int count) {
+    pthread_mutex_lock(&log_file.lock);
+    if (log_file.fd < 0) {
+        pthread_mutex_unlock(&log_file.lock);
+        return false;
+    }
+
+    int64_t now_ms = log_now_ms();
+    bool full = log_file.config.max_bytes > 0 && log_file.size >= log_file.config.max_bytes;
+    bool old = log_file.config.max_seconds > 0 && now_ms - log_file.opened_ms >= (int64_t)log_file.config.max_seconds * 1000;
+    if (full || old) {
+        log_file_rotate(now_ms);
+        if (log_file.fd < 0) {
+            pthread_mutex_unlock(&log_file.lock);
+            return false;
+        }
+    }
+
+    while (count > 0) {
+        ssize_t n = writev(log_file.fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        log_file.size += n;
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    if (log_file.config.sync_ms > 0 && now_ms - log_file.synced_ms >= log_file.config.sync_ms) {
+        fdatasync(log_file.fd);
+        log_file.synced_ms = now_ms;
+    }
+
+    pthread_mutex_unlock(&log_file.lock);
+    return true;
+}
+
+bool log_file_open(Log_File_Config config) {
+    int fd = log_file_open_fd(config.path, false);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open log file %s\n", config.path);
+        return false;
+    }
+
+    size_t path_length = strlen(config.path) + 1;
+    char* path = (char*)malloc(path_length);
+    if (!path) {
+        fprintf(stderr, "Could not allocate log file path\n");
+        close(fd);
+        return false;
+    }
+    memcpy(path, config.path, path_length);
+
+    struct stat info;
+    int64_t size = fstat(fd, &info) == 0 ? (int64_t)info.st_size : 0;
+
+    log_file_close();
+    pthread_mutex_lock(&log_file.lock);
+    log_file.path = path;
+    log_file.config = config;
+    log_file.config.path = path;
+    log_file.size = size;
+    log_file.opened_ms = log_now_ms();
+    log_file.synced_ms = log_file.opened_ms;
+    __atomic_store_n(&log_file.fd, fd, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&log_file.lock);
+    return true;
+}
+
+void log_file_close(void) {
+    log_flush();
+
+    pthread_mutex_lock(&log_file.lock);
+    if (log_file.fd >= 0) {
+        if (log_file.config.sync_ms > 0) fdatasync(log_file.fd);
+        close(log_file.fd);
+    }
+    free(log_file.path);
+    log_file.path = NULL;
+    __atomic_store_n(&log_file.fd, -1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&log_file.lock);
+}
+
+#define LOG_BATCH_SIZE (64 * 1024)
+
+static struct {
+    char buffer[LOG_BATCH_SIZE];
+    int cursor;
+} log_batch;  // only touched while holding draining
+
+static void log_batch_write(void) {
+    if (!log_batch.cursor) return;
+
+    if (log_async.binary) {
+        fwrite(log_batch.buffer, 1, log_batch.cursor, log_async.binary);
+    }
+    else {
+        struct iovec iov = {.iov_base = log_batch.buffer, .iov_len = (size_t)log_batch.cursor};
+        if (!log_file_write(&iov, 1)) fwrite(log_batch.buffer, 1, log_batch.cursor, stderr);
+    }
+    log_batch.cursor = 0;
+}
+
+static void log_batch_reserve(int size) {
+    if (log_batch.cursor + size > LOG_BATCH_SIZE) log_batch_write();
+}
+
+static void log_batch_put(const void* data, int size) {
+    memcpy(log_batch.buffer + log_batch.cursor, data, size);
+    log_batch.cursor += size;
+}
+
+static void log_batch_text(Log_Level level, const char* text, int length) {
+    if (log_async.binary) {
+        uint8_t tag = LOG_RECORD_TEXT;
+        uint8_t level8 = (uint8_t)level;
+        uint16_t length16 = (uint16_t)length;
+        log_batch_reserve(4 + length);
+        log_batch_put(&tag, 1);
+        log_batch_put(&level8, 1);
+        log_batch_put(&length16, 2);
+        log_batch_put(text, length);
+        return;
+    }
+
+    const char* prefix = log_prefix(level);
+    int prefix_length = (int)strlen(prefix);
+    log_batch_reserve(prefix_length + length + 1);
+    log_batch_put(prefix, prefix_length);
+    log_batch_put(text, length);
+    log_batch_put("\n", 1);
+}
+
+static void log_batch_site(Log_Site* site) {
+    uint8_t tag = LOG_RECORD_SITE;
+    uint8_t level8 = (uint8_t)site->level;
+    uint32_t line = (uint32_t)site->line;
+    size_t format_length = strlen(site->format);
+    size_t file_length = strlen(site->file);
+    uint16_t format16 = (uint16_t)(format_length < 0xffff ? format_length : 0xffff);
+    uint16_t file16 = (uint16_t)(file_length < 0xffff ? file_length : 0xffff);
+
+    // a site description can be bigger than the batch, it is written directly
+    log_batch_write();
+    FILE* out = log_async.binary;
+    fwrite(&tag, 1, 1, out);
+    fwrite(&site->id, 4, 1, out);
+    fwrite(&level8, 1, 1, out);
+    fwrite(&line, 4, 1, out);
+    fwrite(&format16, 2, 1, out);
+    fwrite(site->format, 1, format16, out);
+    fwrite(&file16, 2, 1, out);
+    fwrite(site->file, 1, file16, out);
+    site->written_epoch = log_async.epoch;
+}
+
+static void log_batch_event(Log_Site* site, const char* args, int size) {
+    if (!log_async.binary) {
+        char text[LOG_MESSAGE_SIZE];
+        int length = log_format_args(site->format, (const unsigned char*)args, size, text, sizeof(text));
+        log_batch_text(site->level, text, length);
+        return;
+    }
+
+    if (site->written_epoch != log_async.epoch) log_batch_site(site);
+
+    uint8_t tag = LOG_RECORD_EVENT;
+    uint16_t size16 = (uint16_t)size;
+    log_batch_reserve(7 + size);
+    log_batch_put(&tag, 1);
+    log_batch_put(&site->id, 4);
+    log_batch_put(&size16, 2);
+    log_batch_put(args, size);
+}
+
+static void log_drain_lock(void) {
+    while (__atomic_exchange_n(&log_async.draining, true, __ATOMIC_ACQUIRE)) sched_yield();
+}
+
+static void log_drain_unlock(void) {
+    __atomic_store_n(&log_async.draining, false, __ATOMIC_RELEASE);
+}
+
+// moves everything published so far to the output, draining has to be held
+static int log_drain(void) {
+    int drained = 0;
+
+    uint64_t dropped = __atomic_load_n(&log_async.dropped, __ATOMIC_RELAXED);
+    if (dropped != log_async.dropped_reported) {
+        char text[128];
+        int length = snprintf(text, sizeof(text), "%llu log messages dropped, the log ring was full",
+                              (unsigned long long)(dropped - log_async.dropped_reported));
+        log_batch_text(LOG_LEVEL_WARN, text, length);
+        log_async.dropped_reported = dropped;
+    }
+
+    for (;;) {
+        uint64_t pos = log_async.dequeue_pos;
+        Log_Slot* slot = &log_async.slots[pos & log_async.mask];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1) break;
+
+        if (slot->site) {
+            log_batch_event(slot->site, slot->message, slot->length);
+        }
+        else {
+            log_batch_text(slot->level, slot->message, slot->length);
+        }
+
+        __atomic_store_n(&slot->sequence, pos + log_async.mask + 1, __ATOMIC_RELEASE);
+        log_async.dequeue_pos = pos + 1;
+        drained++;
+    }
+
+    log_batch_write();
+    return drained;
+}
+
+static void* log_writer_thread(void* arg) {
+    (void)arg;
+    long backoff_ns = 1000;
+    for (;;) {
+        log_drain_lock();
+        int drained = log_drain();
+        if (drained) fflush(log_async.binary ? log_async.binary : stderr);
+        log_drain_unlock();
+
+        if (drained) {
+            backoff_ns = 1000;
+            continue;
+        }
+        if (__atomic_load_n(&log_async.stop, __ATOMIC_ACQUIRE)) break;
+
+        // producers never signal, so the writer polls with a backoff capped at a millisecond
+        struct timespec wait = {.tv_sec = 0, .tv_nsec = backoff_ns};
+        nanosleep(&wait, NULL);
+        if (backoff_ns < 1000000) backoff_ns *= 2;
+    }
+    return NULL;
+}
+
+bool log_async_start(Log_Async_Config config) {
+    if (log_async.running) return true;
+
+    FILE* binary = NULL;
+    if (config.binary_path) {
+        binary = fopen(config.binary_path, "wb");
+        if (!binary) {
+            fprintf(stderr, "Could not open binary log %s\n", config.binary_path);
+            return false;
+        }
+        fwrite(LOG_BINARY_MAGIC, 1, 8, binary);
+    }
+
+    uint64_t capacity = 2;
+    uint64_t wanted = config.capacity > 0 ? (uint64_t)config.capacity : LOG_ASYNC_DEFAULT_CAPACITY;
+    while (capacity < wanted) capacity *= 2;
+
+    log_async.slots = (Log_Slot*)malloc(capacity * sizeof(Log_Slot));
+    if (!log_async.slots) {
+        if (binary) fclose(binary);
+        return false;
+    }
+    for (uint64_t i = 0; i < capacity; i++) {
+        log_async.slots[i].sequence = i;
+    }
+
+    log_async.mask = capacity - 1;
+    log_async.full_policy = config.full_policy;
+    log_async.binary = binary;
+    log_async.epoch += 1;
+    log_async.enqueue_pos = 0;
+    log_async.dequeue_pos = 0;
+    log_async.dropped = 0;
+    log_async.dropped_reported = 0;
+    log_async.stop = false;
+    log_async.draining = false;
+
+    if (pthread_create(&log_async.writer, NULL, log_writer_thread, NULL) != 0) {
+        free(log_async.slots);
+        log_async.slots = NULL;
+        if (binary) fclose(binary);
+        log_async.binary = NULL;
+        return false;
+    }
+
+    __atomic_store_n(&log_async.running, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void log_async_stop(void) {
+    if (!log_async.running) return;
+
+    __atomic_store_n(&log_async.running, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&log_async.stop, true, __ATOMIC_RELEASE);
+    pthread_join(log_async.writer, NULL);
+
+    // producers that saw running before it was cleared may still be publishing
+    log_flush();
+    free(log_async.slots);
+    log_async.slots = NULL;
+    if (log_async.binary) fclose(log_async.binary);
+    log_async.binary = NULL;
+    log_batch.cursor = 0;
+}
+
+void log_flush(void) {
+    if (log_async.slots) {
+        log_drain_lock();
+        log_drain();
+        if (log_async.binary) fflush(log_async.binary);
+        log_drain_unlock();
+    }
+    fflush(stderr);
+}
+
+static void log_signal_write(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+}
+
+void log_flush_from_signal(void) {
+    if (!__atomic_load_n(&log_async.running, __ATOMIC_ACQUIRE)) return;
+    if (__atomic_exchange_n(&log_async.draining, true, __ATOMIC_ACQUIRE)) return;
+
+    int saved_errno = errno;
+    int fd = __atomic_load_n(&log_file.fd, __ATOMIC_RELAXED);
+    bool colors = fd < 0 && __atomic_load_n(&log_stderr_colors, __ATOMIC_RELAXED) > 0;
+    if (fd < 0) fd = STDERR_FILENO;
+
+    for (;;) {
+        uint64_t pos = log_async.dequeue_pos;
+        Log_Slot* slot = &log_async.slots[pos & log_async.mask];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + 1) break;
+
+        const char* prefix = colors ? log_level_prefix(slot->level) : log_level_plain_prefix(slot->level);
+        log_signal_write(fd, prefix, strlen(prefix));
+        if (slot->site) log_signal_write(fd, slot->site->format, strlen(slot->site->format));
+        else log_signal_write(fd, slot->message, (size_t)slot->length);
+        log_signal_write(fd, "\n", 1);
+
+        __atomic_store_n(&slot->sequence, pos + log_async.mask + 1, __ATOMIC_RELEASE);
+        log_async.dequeue_pos = pos + 1;
+    }
+
+    log_drain_unlock();
+    errno = saved_errno;
+}
+
+uint64_t log_dropped_count(void) {
+    return __atomic_load_n(&log_async.dropped, __ATOMIC_RELAXED);
+}
+
+// claims a slot, returns NULL if the message has to be dropped
+static Log_Slot* log_claim_slot(uint64_t* claimed) {
+    uint64_t pos = __atomic_load_n(&log_async.enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        Log_Slot* slot = &log_async.slots[pos & log_async.mask];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(sequence - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&log_async.enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *claimed = pos;
+                return slot;
+            }
+        }
+        else if (diff < 0) {
+            // full
+            if (log_async.full_policy != LOG_FULL_BLOCK) {
+                if (log_async.full_policy == LOG_FULL_COUNT_AND_DROP) {
+                    __atomic_fetch_add(&log_async.dropped, 1, __ATOMIC_RELAXED);
+                }
+                return NULL;
+            }
+            sched_yield();
+            pos = __atomic_load_n(&log_async.enqueue_pos, __ATOMIC_RELAXED);
+        }
+        else {
+            pos = __atomic_load_n(&log_async.enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void log_vlog(Log_Level level, const char* msg, va_list args) {
+    if (__atomic_load_n(&log_async.running, __ATOMIC_ACQUIRE)) {
+        uint64_t pos;
+        Log_Slot* slot = log_claim_slot(&pos);
+        if (!slot) return;
+
+        int length = vsnprintf(slot->message, sizeof(slot->message), msg, args);
+        slot->level = level;
+        slot->site = NULL;
+        slot->length = length < 0 ? 0 : length < (int)sizeof(slot->message) ? length : (int)sizeof(slot->message) - 1;
+        __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    char formatted_message[LOG_MESSAGE_SIZE];
+    int length = vsnprintf(formatted_message, sizeof(formatted_message), msg, args);
+    length = length < 0 ? 0 : length < (int)sizeof(formatted_message) ? length : (int)sizeof(formatted_message) - 1;
+
+    const char* prefix = log_prefix(level);
+    struct iovec iov[3] = {
+        {.iov_base = (void*)prefix, .iov_len = strlen(prefix)},
+        {.iov_base = formatted_message, .iov_len = (size_t)length},
+        {.iov_base = (void*)"\n", .iov_len = 1},
+    };
+    if (!log_file_write(iov, 3)) fprintf(stderr, "%s%s\n", prefix, formatted_message);
+}
+
 void log_log(Log_Level level, char const * const msg, ...) {
-    char formatted_message[1024];
     va_list args;
     va_start(args, msg);
-    vsnprintf(formatted_message, sizeof(formatted_message), msg, args);
+    log_vlog(level, msg, args);
     va_end(args);
+}
 
-    switch (level) {
-    case LOG_LEVEL_INFO: {
-        fprintf(stderr, "\033[32;1;1m[INFO]:\033[0m %s\n", formatted_message);
-        break;
+int log_level_threshold = LOG_LEVEL_INFO;
+
+void log_set_level(Log_Level level) {
+    __atomic_store_n(&log_level_threshold, (int)level, __ATOMIC_RELAXED);
+}
+
+static void log_register_site(Log_Site* site) {
+    pthread_mutex_lock(&log_site_lock);
+    if (!site->id) {
+        site->arg_count = log_parse_format(site->format, site->arg_kinds, site->arg_precisions);
+        __atomic_store_n(&site->id, ++log_site_count, __ATOMIC_RELEASE);
     }
-    case LOG_LEVEL_WARN: {
-        fprintf(stderr, "\033[33;1;1m[WARNING]:\033[0m %s\n", formatted_message);
-        break;
+    pthread_mutex_unlock(&log_site_lock);
+}
+
+// counts calls per second, the coarse clock is read through the vdso so this never enters the kernel
+static bool log_site_allow(Log_Site* site) {
+    struct timespec now;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#elif defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    timespec_get(&now, TIME_UTC);  // no posix clocks, only the wall clock of c11
+#endif
+    int64_t second = (int64_t)now.tv_sec;
+
+    int64_t window = __atomic_load_n(&site->window, __ATOMIC_RELAXED);
+    if (window != second && __atomic_compare_exchange_n(&site->window, &window, second, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&site->window_count, 0, __ATOMIC_RELAXED);
+        uint32_t suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+        if (suppressed) {
+            log_log(site->level, "%u similar messages suppressed (%s:%d)", suppressed, site->file, site->line);
+        }
     }
-    case LOG_LEVEL_ERROR: {
-        fprintf(stderr, "\033[31;1;1m[ERROR]:\033[0m %s\n", formatted_message);
-        break;
+
+    if (__atomic_fetch_add(&site->window_count, 1, __ATOMIC_RELAXED) < site->per_second) return true;
+    __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+void log_log_site(Log_Site* site, const char* msg, ...) {
+    if (site->per_second && !log_site_allow(site)) return;
+
+    va_list args;
+    va_start(args, msg);
+    if (!site->format) {
+        log_vlog(site->level, msg, args);
+        va_end(args);
+        return;
     }
+
+    if (!__atomic_load_n(&site->id, __ATOMIC_ACQUIRE)) log_register_site(site);
+    if (site->arg_count < 0 || !__atomic_load_n(&log_async.running, __ATOMIC_ACQUIRE)) {
+        log_vlog(site->level, site->format, args);
+        va_end(args);
+        return;
+    }
+
+    uint64_t pos;
+    Log_Slot* slot = log_claim_slot(&pos);
+    if (slot) {
+        slot->level = site->level;
+        slot->site = site;
+        slot->length = log_record_args(site, (unsigned char*)slot->message, sizeof(slot->message), args);
+        __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    }
+    va_end(args);
+}
+
+typedef struct {
+    char* format;
+    Log_Level level;
+} Log_Decoded_Site;
+
+// ids count the call sites of one program from 1, anything this big comes from a corrupt file
+#define LOG_DECODE_MAX_SITES (1u << 24)
+
+static bool log_decode_read(FILE* in, void* data, size_t size) {
+    return fread(data, 1, size, in) == size;
+}
+
+// reads instead of seeking so a pipe works as input
+static bool log_decode_skip(FILE* in, size_t size) {
+    char scratch[256];
+    while (size > 0) {
+        size_t chunk = size < sizeof(scratch) ? size : sizeof(scratch);
+        if (!log_decode_read(in, scratch, chunk)) return false;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool log_decode(FILE* in, FILE* out) {
+    char magic[8];
+    if (!log_decode_read(in, magic, sizeof(magic)) || memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)) != 0) {
+        fprintf(stderr, "Not a binary log\n");
+        return false;
+    }
+
+    Log_Decoded_Site* sites = NULL;
+    uint32_t site_capacity = 0;
+    bool ok = true;
+    char args[LOG_MESSAGE_SIZE];
+    char text[LOG_MESSAGE_SIZE];
+
+    for (;;) {
+        uint8_t tag;
+        if (!log_decode_read(in, &tag, 1)) break;
+
+        if (tag == LOG_RECORD_SITE) {
+            uint32_t id, line;
+            uint8_t level;
+            uint16_t format_length, file_length;
+            if (!log_decode_read(in, &id, 4) || id >= LOG_DECODE_MAX_SITES || !log_decode_read(in, &level, 1) ||
+                !log_decode_read(in, &line, 4) || !log_decode_read(in, &format_length, 2)) {
+                ok = false;
+                break;
+            }
+            char* format = (char*)malloc((size_t)format_length + 1);
+            if (!format || !log_decode_read(in, format, format_length) || !log_decode_read(in, &file_length, 2) ||
+                !log_decode_skip(in, file_length)) {
+                free(format);
+                ok = false;
+                break;
+            }
+            format[format_length] = '\0';
+
+            if (id >= site_capacity) {
+                uint32_t capacity = site_capacity ? site_capacity : 64;
+                while (capacity <= id) capacity *= 2;
+                Log_Decoded_Site* grown = (Log_Decoded_Site*)realloc(sites, capacity * sizeof(Log_Decoded_Site));
+                if (!grown) {
+                    free(format);
+                    ok = false;
+                    break;
+                }
+                memset(grown + site_capacity, 0, (capacity - site_capacity) * sizeof(Log_Decoded_Site));
+                sites = grown;
+                site_capacity = capacity;
+            }
+            free(sites[id].format);
+            sites[id] = (Log_Decoded_Site){.format = format, .level = (Log_Level)level};
+        }
+        else if (tag == LOG_RECORD_EVENT) {
+            uint32_t id;
+            uint16_t size;
+            if (!log_decode_read(in, &id, 4) || !log_decode_read(in, &size, 2) || size > sizeof(args) ||
+                !log_decode_read(in, args, size) || id >= site_capacity || !sites[id].format) {
+                ok = false;
+                break;
+            }
+            log_format_args(sites[id].format, (const unsigned char*)args, size, text, sizeof(text));
+            fprintf(out, "%s%s\n", log_level_plain_prefix(sites[id].level), text);
+        }
+        else if (tag == LOG_RECORD_TEXT) {
+            uint8_t level;
+            uint16_t length;
+            if (!log_decode_read(in, &level, 1) || !log_decode_read(in, &length, 2) || length > sizeof(text) ||
+                !log_decode_read(in, text, length)) {
+                ok = false;
+                break;
+            }
+            fprintf(out, "%s%.*s\n", log_level_plain_prefix((Log_Level)level), (int)length, text);
+        }
+        else {
+            ok = false;
+            break;
+        }
+    }
+
+    if (!ok) fprintf(stderr, "Binary log is truncated or corrupt\n");
+    for (uint32_t i = 0; i < site_capacity; i++) {
+        free(sites[i].format);
     }
+    free(sites);
+    return ok;
 }
 
 #undef ANSI_RED
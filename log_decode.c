@@ -0,0 +1,31 @@
+// prints a binary log written with Log_Async_Config.binary_path as text
+// cc -O2 -o log_decode log_decode.c -lpthread -lm
+// usage: log_decode file.log [out.txt]
+
+#define LOG_IMPLEMENTATION
+#include "log.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s file.log [out.txt]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "Could not open file %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Could not open file %s\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    bool ok = log_decode(in, out);
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,524 @@
+#ifndef _RASTER
+#define _RASTER
+
+// drawing into a Canvas
+// rows are written through span kernels: solid fills store a 96 byte colour pattern 32 bytes at a time (32 pixels per loop),
+// gradients and blends work on 8 pixels per avx2 iteration, with sse2 or scalar versions picked at runtime
+// like the scanners in string_builder.h, define RASTER_NO_SIMD to always use the scalar loops
+// everything is clipped to the canvas, the _clip variants also to a rectangle (e.g. one tile of the canvas)
+// and draw exactly the pixels the unclipped call would draw inside it
+// the alpha of Color is ignored, canvas_blit is the blended operation
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utility.h"
+
+typedef struct {
+    int x0, y0;
+    int x1, y1;  // excluded
+} Clip_Rect;
+
+Clip_Rect canvas_rect(Canvas canvas);
+Clip_Rect raster_intersect(Clip_Rect a, Clip_Rect b);  // empty results keep x1 >= x0 and y1 >= y0
+
+void canvas_clear(Canvas canvas, Color color);
+void canvas_fill_rect(Canvas canvas, ivec2 min, ivec2 max /* excluded */, Color color);
+void canvas_draw_line(Canvas canvas, ivec2 a, ivec2 b /* both ends are drawn */, Color color);
+// pixels whose centres are inside (with a top left rule for the edges) get the barycentric mix of the vertex colours
+void canvas_fill_triangle(Canvas canvas, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc);
+// source over blend of a rgba image with its top left corner at pos
+void canvas_blit(Canvas canvas, ivec2 pos, const rgba_t* pixels, int width, int height);
+
+void canvas_fill_rect_clip(Canvas canvas, Clip_Rect clip, ivec2 min, ivec2 max, Color color);
+void canvas_draw_line_clip(Canvas canvas, Clip_Rect clip, ivec2 a, ivec2 b, Color color);
+void canvas_fill_triangle_clip(Canvas canvas, Clip_Rect clip, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc);
+void canvas_blit_clip(Canvas canvas, Clip_Rect clip, ivec2 pos, const rgba_t* pixels, int width, int height);
+
+#ifdef RASTER_IMPLEMENTATION
+
+#include <math.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(RASTER_NO_SIMD)
+#define RASTER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*Raster_Fill_Span)(rgb_t* dst, int count, rgb_t color);
+// channel values at pixel i are start + (first + i) * step, rounded and clamped
+typedef void (*Raster_Gradient_Span)(rgb_t* dst, int count, int first, const float start[3], const float step[3]);
+typedef void (*Raster_Blend_Span)(rgb_t* dst, const rgba_t* src, int count);
+
+static void raster_fill_span_scalar(rgb_t* dst, int count, rgb_t color) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+static unsigned char raster_channel(float start, float step, int i) {
+    float v = start + (float)i * step + 0.5f;
+    v = v < 0 ? 0 : v > 255 ? 255 : v;
+    return (unsigned char)(int)v;
+}
+
+static void raster_gradient_span_scalar(rgb_t* dst, int count, int first, const float start[3], const float step[3]) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = (rgb_t){
+            .r = raster_channel(start[0], step[0], first + i),
+            .g = raster_channel(start[1], step[1], first + i),
+            .b = raster_channel(start[2], step[2], first + i),
+        };
+    }
+}
+
+// round(v / 255) for v up to 255 * 255
+static unsigned char raster_div255(unsigned int v) {
+    v += 128;
+    return (unsigned char)((v + (v >> 8)) >> 8);
+}
+
+static void raster_blend_span_scalar(rgb_t* dst, const rgba_t* src, int count) {
+    for (int i = 0; i < count; i++) {
+        unsigned int a = src[i].a;
+        dst[i] = (rgb_t){
+            .r = raster_div255(src[i].r * a + dst[i].r * (255 - a)),
+            .g = raster_div255(src[i].g * a + dst[i].g * (255 - a)),
+            .b = raster_div255(src[i].b * a + dst[i].b * (255 - a)),
+        };
+    }
+}
+
+#ifdef RASTER_SIMD_X86
+
+static void raster_fill_pattern(unsigned char* pattern, int size, rgb_t color) {
+    for (int i = 0; i < size; i += 3) {
+        pattern[i] = color.r;
+        pattern[i + 1] = color.g;
+        pattern[i + 2] = color.b;
+    }
+}
+
+__attribute__((target("sse2")))
+static void raster_fill_span_sse2(rgb_t* dst, int count, rgb_t color) {
+    if (count >= 16) {
+        unsigned char pattern[48];
+        raster_fill_pattern(pattern, sizeof(pattern), color);
+        __m128i p0 = _mm_loadu_si128((const __m128i*)pattern);
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+        __m128i p2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+
+        unsigned char* out = (unsigned char*)dst;
+        for (; count >= 16; count -= 16, out += 48, dst += 16) {
+            _mm_storeu_si128((__m128i*)out, p0);
+            _mm_storeu_si128((__m128i*)(out + 16), p1);
+            _mm_storeu_si128((__m128i*)(out + 32), p2);
+        }
+    }
+    raster_fill_span_scalar(dst, count, color);
+}
+
+__attribute__((target("avx2")))
+static void raster_fill_span_avx2(rgb_t* dst, int count, rgb_t color) {
+    if (count >= 32) {
+        unsigned char pattern[96];
+        raster_fill_pattern(pattern, sizeof(pattern), color);
+        __m256i p0 = _mm256_loadu_si256((const __m256i*)pattern);
+        __m256i p1 = _mm256_loadu_si256((const __m256i*)(pattern + 32));
+        __m256i p2 = _mm256_loadu_si256((const __m256i*)(pattern + 64));
+
+        unsigned char* out = (unsigned char*)dst;
+        for (; count >= 32; count -= 32, out += 96, dst += 32) {
+            _mm256_storeu_si256((__m256i*)out, p0);
+            _mm256_storeu_si256((__m256i*)(out + 32), p1);
+            _mm256_storeu_si256((__m256i*)(out + 64), p2);
+        }
+    }
+    _mm256_zeroupper();  // the tail runs sse code, which stalls on dirty upper halves
+    raster_fill_span_scalar(dst, count, color);
+}
+
+// 8 pixels as 4 byte rgbx per 32 bit lane -> 12 packed bytes at the bottom of each 128 bit half
+#define RASTER_PACK_RGB_MASK 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+#define RASTER_UNPACK_RGB_MASK 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+
+// the halves are stored 12 bytes apart with 16 byte stores, so each iteration writes 4 bytes past its 8 pixels,
+// those belong to the next two pixels of the span and get written again afterwards
+__attribute__((target("avx2")))
+static void raster_gradient_span_avx2(rgb_t* dst, int count, int first, const float start[3], const float step[3]) {
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(255);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i pack = _mm256_setr_epi8(RASTER_PACK_RGB_MASK, RASTER_PACK_RGB_MASK);
+
+    __m256 r0 = _mm256_set1_ps(start[0]), g0 = _mm256_set1_ps(start[1]), b0 = _mm256_set1_ps(start[2]);
+    __m256 dr = _mm256_set1_ps(step[0]), dg = _mm256_set1_ps(step[1]), db = _mm256_set1_ps(step[2]);
+
+    int i = 0;
+    unsigned char* out = (unsigned char*)dst;
+    for (; i + 10 <= count; i += 8) {
+        __m256 index = _mm256_add_ps(_mm256_set1_ps((float)(first + i)), lane);
+        // same operations and order as raster_channel so the scalar tail matches
+        __m256 r = _mm256_add_ps(_mm256_add_ps(r0, _mm256_mul_ps(index, dr)), half);
+        __m256 g = _mm256_add_ps(_mm256_add_ps(g0, _mm256_mul_ps(index, dg)), half);
+        __m256 b = _mm256_add_ps(_mm256_add_ps(b0, _mm256_mul_ps(index, db)), half);
+        __m256i ri = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(r, zero), max));
+        __m256i gi = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(g, zero), max));
+        __m256i bi = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(b, zero), max));
+
+        __m256i rgbx = _mm256_or_si256(ri, _mm256_or_si256(_mm256_slli_epi32(gi, 8), _mm256_slli_epi32(bi, 16)));
+        __m256i packed = _mm256_shuffle_epi8(rgbx, pack);
+        _mm_storeu_si128((__m128i*)(out + i * 3), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128((__m128i*)(out + i * 3 + 12), _mm256_extracti128_si256(packed, 1));
+    }
+
+    _mm256_zeroupper();
+    raster_gradient_span_scalar(dst + i, count - i, first + i, start, step);
+}
+
+// the destination is read and written as two overlapping 16 byte halves 12 bytes apart,
+// the 4 bytes after the 8 pixels pass through unchanged
+__attribute__((target("avx2")))
+static void raster_blend_span_avx2(rgb_t* dst, const rgba_t* src, int count) {
+    const __m256i unpack = _mm256_setr_epi8(RASTER_UNPACK_RGB_MASK, RASTER_UNPACK_RGB_MASK);
+    const __m256i pack = _mm256_setr_epi8(RASTER_PACK_RGB_MASK, RASTER_PACK_RGB_MASK);
+    const __m256i alpha = _mm256_setr_epi8(3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1,
+                                           3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1);
+    const __m256i tail = _mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1);
+    const __m256i full = _mm256_set1_epi16(255);
+    const __m256i round = _mm256_set1_epi16(128);
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    unsigned char* out = (unsigned char*)dst;
+    for (; i + 10 <= count; i += 8) {
+        unsigned char* p = out + i * 3;
+        __m256i d = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                            _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d_rgbx = _mm256_shuffle_epi8(d, unpack);
+        __m256i a = _mm256_shuffle_epi8(s, alpha);
+
+        __m256i result[2];
+        for (int h = 0; h < 2; h++) {
+            __m256i s16 = h ? _mm256_unpackhi_epi8(s, zero) : _mm256_unpacklo_epi8(s, zero);
+            __m256i d16 = h ? _mm256_unpackhi_epi8(d_rgbx, zero) : _mm256_unpacklo_epi8(d_rgbx, zero);
+            __m256i a16 = h ? _mm256_unpackhi_epi8(a, zero) : _mm256_unpacklo_epi8(a, zero);
+            __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(s16, a16), _mm256_mullo_epi16(d16, _mm256_sub_epi16(full, a16)));
+            v = _mm256_add_epi16(v, round);
+            result[h] = _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+        }
+
+        __m256i packed = _mm256_shuffle_epi8(_mm256_packus_epi16(result[0], result[1]), pack);
+        packed = _mm256_or_si256(packed, _mm256_and_si256(d, tail));
+        _mm_storeu_si128((__m128i*)p, _mm256_castsi256_si128(packed));
+        _mm_storeu_si128((__m128i*)(p + 12), _mm256_extracti128_si256(packed, 1));
+    }
+
+    _mm256_zeroupper();
+    raster_blend_span_scalar(dst + i, src + i, count - i);
+}
+
+#undef RASTER_PACK_RGB_MASK
+#undef RASTER_UNPACK_RGB_MASK
+
+#endif  // RASTER_SIMD_X86
+
+static struct {
+    Raster_Fill_Span fill;
+    Raster_Gradient_Span gradient;
+    Raster_Blend_Span blend;
+} raster_kernels;
+
+static void raster_pick_kernels(void) {
+    if (__atomic_load_n(&raster_kernels.fill, __ATOMIC_ACQUIRE)) return;
+
+    Raster_Fill_Span fill = raster_fill_span_scalar;
+    Raster_Gradient_Span gradient = raster_gradient_span_scalar;
+    Raster_Blend_Span blend = raster_blend_span_scalar;
+#ifdef RASTER_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        fill = raster_fill_span_avx2;
+        gradient = raster_gradient_span_avx2;
+        blend = raster_blend_span_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        fill = raster_fill_span_sse2;
+    }
+#endif  // RASTER_SIMD_X86
+
+    raster_kernels.gradient = gradient;
+    raster_kernels.blend = blend;
+    __atomic_store_n(&raster_kernels.fill, fill, __ATOMIC_RELEASE);
+}
+
+Clip_Rect raster_intersect(Clip_Rect a, Clip_Rect b) {
+    Clip_Rect r = {
+        .x0 = a.x0 > b.x0 ? a.x0 : b.x0,
+        .y0 = a.y0 > b.y0 ? a.y0 : b.y0,
+        .x1 = a.x1 < b.x1 ? a.x1 : b.x1,
+        .y1 = a.y1 < b.y1 ? a.y1 : b.y1,
+    };
+    if (r.x1 < r.x0) r.x1 = r.x0;
+    if (r.y1 < r.y0) r.y1 = r.y0;
+    return r;
+}
+
+static rgb_t* raster_row(Canvas canvas, int y) {
+    return canvas.canvas + (size_t)y * canvas.width;
+}
+
+Clip_Rect canvas_rect(Canvas canvas) {
+    return (Clip_Rect){.x0 = 0, .y0 = 0, .x1 = canvas.width, .y1 = canvas.height};
+}
+
+void canvas_clear(Canvas canvas, Color color) {
+    raster_pick_kernels();
+    size_t total = (size_t)canvas.width * canvas.height;
+    for (size_t done = 0; done < total;) {
+        int count = total - done > (1u << 30) ? 1 << 30 : (int)(total - done);
+        raster_kernels.fill(canvas.canvas + done, count, color_to_rgb(color));
+        done += count;
+    }
+}
+
+void canvas_fill_rect_clip(Canvas canvas, Clip_Rect clip, ivec2 min, ivec2 max, Color color) {
+    raster_pick_kernels();
+    Clip_Rect r = raster_intersect(raster_intersect(clip, canvas_rect(canvas)),
+                                   (Clip_Rect){.x0 = min.x, .y0 = min.y, .x1 = max.x, .y1 = max.y});
+    rgb_t rgb = color_to_rgb(color);
+    for (int y = r.y0; y < r.y1; y++) {
+        raster_kernels.fill(raster_row(canvas, y) + r.x0, r.x1 - r.x0, rgb);
+    }
+}
+
+void canvas_fill_rect(Canvas canvas, ivec2 min, ivec2 max, Color color) {
+    canvas_fill_rect_clip(canvas, canvas_rect(canvas), min, max, color);
+}
+
+// the pixel at step k along the major axis is offset round(k * minor / major) (halves up) on the minor axis,
+// computed from k directly so a clipped line starts on exactly the pixel the whole line would have
+void canvas_draw_line_clip(Canvas canvas, Clip_Rect clip, ivec2 a, ivec2 b, Color color) {
+    raster_pick_kernels();
+    Clip_Rect r = raster_intersect(clip, canvas_rect(canvas));
+    if (r.x0 == r.x1 || r.y0 == r.y1) return;
+    rgb_t rgb = color_to_rgb(color);
+
+    if (a.y == b.y) {
+        int x0 = a.x < b.x ? a.x : b.x, x1 = (a.x < b.x ? b.x : a.x) + 1;
+        canvas_fill_rect_clip(canvas, r, (ivec2){x0, a.y}, (ivec2){x1, a.y + 1}, color);
+        return;
+    }
+
+    int64_t dx = (int64_t)b.x - a.x, dy = (int64_t)b.y - a.y;
+    bool steep = llabs(dy) > llabs(dx);
+    int64_t major = steep ? llabs(dy) : llabs(dx);
+    int64_t minor = steep ? llabs(dx) : llabs(dy);
+    int major_step = steep ? (dy > 0 ? 1 : -1) : (dx > 0 ? 1 : -1);
+    int minor_step = steep ? (dx > 0 ? 1 : -1) : (dy > 0 ? 1 : -1);
+    int major_start = steep ? a.y : a.x;
+    int minor_start = steep ? a.x : a.y;
+    int major_lo = steep ? r.y0 : r.x0, major_hi = steep ? r.y1 : r.x1;
+    int minor_lo = steep ? r.x0 : r.y0, minor_hi = steep ? r.x1 : r.y1;
+
+    // steps whose major coordinate is inside the clip
+    int64_t k0, k1;
+    if (major_step > 0) {
+        k0 = major_lo - (int64_t)major_start;
+        k1 = major_hi - 1 - (int64_t)major_start;
+    }
+    else {
+        k0 = (int64_t)major_start - (major_hi - 1);
+        k1 = (int64_t)major_start - major_lo;
+    }
+    if (k0 < 0) k0 = 0;
+    if (k1 > major) k1 = major;
+
+    // and whose minor coordinate is, the offset only grows with k so a tile the line misses costs nothing
+    if (minor > 0) {
+        int64_t m0 = minor_step > 0 ? minor_lo - (int64_t)minor_start : (int64_t)minor_start - (minor_hi - 1);
+        int64_t m1 = minor_step > 0 ? minor_hi - 1 - (int64_t)minor_start : (int64_t)minor_start - minor_lo;
+        if (m1 < 0 || m0 > minor) return;
+        if (m1 > minor) m1 = minor;
+        if (m0 > 0) {
+            // first k with offset >= m0
+            int64_t k = ((2 * m0 - 1) * major + 2 * minor - 1) / (2 * minor);
+            if (k > k0) k0 = k;
+        }
+        // last k with offset <= m1
+        int64_t k = ((2 * m1 + 1) * major + 2 * minor - 1) / (2 * minor) - 1;
+        if (k < k1) k1 = k;
+    }
+    else if (minor_start < minor_lo || minor_start >= minor_hi) {
+        return;
+    }
+    if (k0 > k1) return;
+
+    int64_t offset = (2 * k0 * minor + major) / (2 * major);
+    int64_t remainder = (2 * k0 * minor + major) % (2 * major);
+    for (int64_t k = k0; k <= k1; k++) {
+        int64_t u = major_start + k * major_step;
+        int64_t v = minor_start + offset * minor_step;
+        if (v >= minor_lo && v < minor_hi) {
+            int x = (int)(steep ? v : u), y = (int)(steep ? u : v);
+            raster_row(canvas, y)[x] = rgb;
+        }
+
+        remainder += 2 * minor;
+        if (remainder >= 2 * major) {
+            remainder -= 2 * major;
+            offset++;
+        }
+    }
+}
+
+void canvas_draw_line(Canvas canvas, ivec2 a, ivec2 b, Color color) {
+    canvas_draw_line_clip(canvas, canvas_rect(canvas), a, b, color);
+}
+
+// e(p) = a * p.x + b * p.y + c, positive inside
+typedef struct {
+    float a, b, c;
+    bool top_left;  // pixel centres exactly on the edge belong to the triangle
+} Raster_Edge;
+
+static Raster_Edge raster_make_edge(vec2 from, vec2 to) {
+    Raster_Edge e = {.a = from.y - to.y, .b = to.x - from.x};
+    e.c = -(e.a * from.x + e.b * from.y);
+    // of two triangles sharing the edge exactly one sees it this way round
+    e.top_left = e.a > 0 || (e.a == 0 && e.b > 0);
+    return e;
+}
+
+static bool raster_edge_inside(const Raster_Edge* e, float px, float py) {
+    float v = e->a * px + e->b * py + e->c;
+    return v > 0 || (v == 0 && e->top_left);
+}
+
+static float raster_clamp(float v, float lo, float hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+static bool raster_triangle_inside(const Raster_Edge edges[3], int x, int y) {
+    float px = x + 0.5f, py = y + 0.5f;
+    return raster_edge_inside(&edges[0], px, py) && raster_edge_inside(&edges[1], px, py) && raster_edge_inside(&edges[2], px, py);
+}
+
+void canvas_fill_triangle_clip(Canvas canvas, Clip_Rect clip, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc) {
+    raster_pick_kernels();
+
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area == 0 || isnan(area)) return;
+    if (area < 0) {
+        // clockwise on screen, swap to keep the edge functions positive inside
+        vec2 t = b; b = c; c = t;
+        Color tc = cb; cb = cc; cc = tc;
+        area = -area;
+    }
+
+    Raster_Edge edges[3] = {raster_make_edge(b, c), raster_make_edge(c, a), raster_make_edge(a, b)};
+
+    // every channel is a plane over the screen: value = dx * px + dy * py + base
+    float weights[3][3];  // per edge: d/dx, d/dy, constant of the barycentric weight
+    for (int i = 0; i < 3; i++) {
+        weights[i][0] = edges[i].a / area;
+        weights[i][1] = edges[i].b / area;
+        weights[i][2] = edges[i].c / area;
+    }
+    float channels[3][3] = {
+        {ca.r, cb.r, cc.r},
+        {ca.g, cb.g, cc.g},
+        {ca.b, cb.b, cc.b},
+    };
+    float plane[3][3];  // per channel: d/dx, d/dy, constant
+    for (int ch = 0; ch < 3; ch++) {
+        for (int k = 0; k < 3; k++) {
+            plane[ch][k] = channels[ch][0] * weights[0][k] + channels[ch][1] * weights[1][k] + channels[ch][2] * weights[2][k];
+        }
+    }
+
+    // clamped to just outside the canvas before converting, far away vertices would not fit an int
+    // the clamp does not depend on the clip so every tile of a call steps the colours from the same bounds.x0
+    float w = (float)canvas.width, h = (float)canvas.height;
+    Clip_Rect bounds = {
+        .x0 = (int)raster_clamp(floorf(fminf(a.x, fminf(b.x, c.x))), -1, w + 1),
+        .y0 = (int)raster_clamp(floorf(fminf(a.y, fminf(b.y, c.y))), -1, h + 1),
+        .x1 = (int)raster_clamp(ceilf(fmaxf(a.x, fmaxf(b.x, c.x))), -1, w + 1) + 1,
+        .y1 = (int)raster_clamp(ceilf(fmaxf(a.y, fmaxf(b.y, c.y))), -1, h + 1) + 1,
+    };
+    Clip_Rect r = raster_intersect(raster_intersect(clip, canvas_rect(canvas)), bounds);
+
+    for (int y = r.y0; y < r.y1; y++) {
+        float py = y + 0.5f;
+
+        // solve each edge for the span of pixel centres inside it
+        float lo = (float)r.x0, hi = (float)r.x1;
+        for (int i = 0; i < 3; i++) {
+            const Raster_Edge* e = &edges[i];
+            float k = e->b * py + e->c;
+            if (e->a > 0) {
+                float t = -k / e->a - 0.5f;
+                if (t > lo) lo = t;
+            }
+            else if (e->a < 0) {
+                float t = -k / e->a - 0.5f;
+                if (t < hi) hi = t;
+            }
+            else if (!(k > 0 || (k == 0 && e->top_left))) {
+                hi = lo;
+            }
+        }
+        if (!(hi > lo - 1)) continue;
+
+        int x0 = (int)ceilf(lo), x1 = (int)ceilf(hi);
+        if (x0 < r.x0) x0 = r.x0;
+        if (x1 > r.x1) x1 = r.x1;
+
+        // the division above rounds, the exact per pixel test decides the end pixels
+        while (x0 < x1 && !raster_triangle_inside(edges, x0, y)) x0++;
+        while (x1 > x0 && !raster_triangle_inside(edges, x1 - 1, y)) x1--;
+        while (x0 > r.x0 && raster_triangle_inside(edges, x0 - 1, y)) x0--;
+        while (x1 < r.x1 && raster_triangle_inside(edges, x1, y)) x1++;
+        if (x0 >= x1) continue;
+
+        // colours are stepped from the left of the unclipped bounds, so a span cut by a tile gets the same values
+        float start[3], step[3];
+        for (int ch = 0; ch < 3; ch++) {
+            start[ch] = plane[ch][0] * (bounds.x0 + 0.5f) + plane[ch][1] * py + plane[ch][2];
+            step[ch] = plane[ch][0];
+        }
+        raster_kernels.gradient(raster_row(canvas, y) + x0, x1 - x0, x0 - bounds.x0, start, step);
+    }
+}
+
+void canvas_fill_triangle(Canvas canvas, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc) {
+    canvas_fill_triangle_clip(canvas, canvas_rect(canvas), a, b, c, ca, cb, cc);
+}
+
+void canvas_blit_clip(Canvas canvas, Clip_Rect clip, ivec2 pos, const rgba_t* pixels, int width, int height) {
+    raster_pick_kernels();
+    Clip_Rect r = raster_intersect(raster_intersect(clip, canvas_rect(canvas)),
+                                   (Clip_Rect){.x0 = pos.x, .y0 = pos.y, .x1 = pos.x + width, .y1 = pos.y + height});
+    for (int y = r.y0; y < r.y1; y++) {
+        const rgba_t* src = pixels + (size_t)(y - pos.y) * width + (r.x0 - pos.x);
+        raster_kernels.blend(raster_row(canvas, y) + r.x0, src, r.x1 - r.x0);
+    }
+}
+
+void canvas_blit(Canvas canvas, ivec2 pos, const rgba_t* pixels, int width, int height) {
+    canvas_blit_clip(canvas, canvas_rect(canvas), pos, pixels, width, height);
+}
+
+#endif // RASTER_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _RASTER
@@ -0,0 +1,463 @@
+#ifndef _RENDER
+#define _RENDER
+
+// tiled multithreaded drawing into a Canvas
+// draw calls are recorded into a Render_List, render_list_draw bins them per tile and runs the tiles on a pool of threads,
+// every tile replays its commands in order through the _clip functions of raster.h so the result is byte for byte
+// the one of drawing the list on a single thread
+// tiles are 128 pixels (6 cache lines) wide, when rows do not start on a cache line (width * 3 not a multiple of 64)
+// a whole row of tiles is the unit of work and its height is rounded so it starts on one, so threads never share a line
+// work is split in contiguous runs per thread, a thread that runs out steals half of what is left in another one's run
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "raster.h"
+
+#define RENDER_TILE_WIDTH 128
+#define RENDER_TILE_HEIGHT 32
+
+typedef enum {
+    RENDER_CLEAR,
+    RENDER_RECT,
+    RENDER_LINE,
+    RENDER_TRIANGLE,
+    RENDER_BLIT,
+} Render_Kind;
+
+typedef struct {
+    Render_Kind kind;
+    Clip_Rect bounds;  // pixels the command may touch
+    union {
+        struct { Color color; } clear;
+        struct { ivec2 min, max; Color color; } rect;
+        struct { ivec2 a, b; Color color; } line;
+        struct { vec2 p[3]; Color c[3]; } triangle;
+        struct { ivec2 pos; const rgba_t* pixels; int width, height; } blit;  // pixels are read when the list is drawn
+    };
+} Render_Command;
+
+typedef struct {
+    Render_Command* commands;
+    int count;
+    int capacity;
+} Render_List;
+
+// a run of units [next, end) packed in one word so the owner and thieves can both take from it with a compare and swap
+typedef struct {
+    uint64_t range;  // next in the low 32 bits, end in the high ones
+    char padding[56];
+} Render_Queue;
+
+typedef struct {
+    int thread_count;  // including the thread calling render_list_draw
+    pthread_t* threads;
+    Render_Queue* queues;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation;
+    int running;       // threads not done with the current frame
+    bool quit;
+
+    // the frame being drawn
+    Canvas canvas;
+    const Render_List* list;
+    int tiles_x, bands, band_height;
+    bool tile_units;   // units are single tiles instead of rows of tiles
+    int* bin_offsets;  // per tile into bin_commands, tile count + 1 entries
+    int* bin_commands;
+    int bin_tile_capacity, bin_command_capacity;
+} Render_Pool;
+
+Render_List make_render_list(void);
+void render_list_reset(Render_List* list);  // keeps the memory
+void render_list_free(Render_List* list);
+
+void render_clear(Render_List* list, Color color);
+void render_fill_rect(Render_List* list, ivec2 min, ivec2 max /* excluded */, Color color);
+void render_draw_line(Render_List* list, ivec2 a, ivec2 b, Color color);
+void render_fill_triangle(Render_List* list, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc);
+void render_blit(Render_List* list, ivec2 pos, const rgba_t* pixels, int width, int height);
+
+bool render_pool_init(Render_Pool* pool, int thread_count /* 0 for one per core */);
+void render_pool_free(Render_Pool* pool);
+
+// pool can be NULL to draw everything on the calling thread in submission order
+void render_list_draw(Canvas canvas, const Render_List* list, Render_Pool* pool);
+
+#ifdef RENDER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+Render_List make_render_list(void) {
+    return (Render_List){.commands = NULL, .count = 0, .capacity = 0};
+}
+
+void render_list_reset(Render_List* list) {
+    list->count = 0;
+}
+
+void render_list_free(Render_List* list) {
+    free(list->commands);
+    *list = make_render_list();
+}
+
+static Render_Command* render_push(Render_List* list, Render_Kind kind, Clip_Rect bounds) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        Render_Command* commands = (Render_Command*)realloc(list->commands, capacity * sizeof(Render_Command));
+        if (!commands) panic("Memory allocation failure");
+        list->commands = commands;
+        list->capacity = capacity;
+    }
+
+    Render_Command* command = &list->commands[list->count++];
+    memset(command, 0, sizeof(*command));
+    command->kind = kind;
+    command->bounds = bounds;
+    return command;
+}
+
+// float to pixel coordinate without overflowing the int
+static int render_coordinate(float v) {
+    if (!(v > -1e9f)) return -1000000000;
+    if (v > 1e9f) return 1000000000;
+    return (int)v;
+}
+
+void render_clear(Render_List* list, Color color) {
+    Clip_Rect everything = {.x0 = INT32_MIN, .y0 = INT32_MIN, .x1 = INT32_MAX, .y1 = INT32_MAX};
+    render_push(list, RENDER_CLEAR, everything)->clear.color = color;
+}
+
+void render_fill_rect(Render_List* list, ivec2 min, ivec2 max, Color color) {
+    Render_Command* command = render_push(list, RENDER_RECT, (Clip_Rect){.x0 = min.x, .y0 = min.y, .x1 = max.x, .y1 = max.y});
+    command->rect.min = min;
+    command->rect.max = max;
+    command->rect.color = color;
+}
+
+void render_draw_line(Render_List* list, ivec2 a, ivec2 b, Color color) {
+    Clip_Rect bounds = {
+        .x0 = a.x < b.x ? a.x : b.x,
+        .y0 = a.y < b.y ? a.y : b.y,
+        .x1 = (a.x < b.x ? b.x : a.x) + 1,
+        .y1 = (a.y < b.y ? b.y : a.y) + 1,
+    };
+    Render_Command* command = render_push(list, RENDER_LINE, bounds);
+    command->line.a = a;
+    command->line.b = b;
+    command->line.color = color;
+}
+
+void render_fill_triangle(Render_List* list, vec2 a, vec2 b, vec2 c, Color ca, Color cb, Color cc) {
+    Clip_Rect bounds = {
+        .x0 = render_coordinate(floorf(fminf(a.x, fminf(b.x, c.x)))),
+        .y0 = render_coordinate(floorf(fminf(a.y, fminf(b.y, c.y)))),
+        .x1 = render_coordinate(ceilf(fmaxf(a.x, fmaxf(b.x, c.x)))) + 1,
+        .y1 = render_coordinate(ceilf(fmaxf(a.y, fmaxf(b.y, c.y)))) + 1,
+    };
+    Render_Command* command = render_push(list, RENDER_TRIANGLE, bounds);
+    command->triangle.p[0] = a;
+    command->triangle.p[1] = b;
+    command->triangle.p[2] = c;
+    command->triangle.c[0] = ca;
+    command->triangle.c[1] = cb;
+    command->triangle.c[2] = cc;
+}
+
+void render_blit(Render_List* list, ivec2 pos, const rgba_t* pixels, int width, int height) {
+    Render_Command* command = render_push(list, RENDER_BLIT, (Clip_Rect){.x0 = pos.x, .y0 = pos.y, .x1 = pos.x + width, .y1 = pos.y + height});
+    command->blit.pos = pos;
+    command->blit.pixels = pixels;
+    command->blit.width = width;
+    command->blit.height = height;
+}
+
+static void render_command(Canvas canvas, Clip_Rect clip, const Render_Command* command) {
+    switch (command->kind) {
+    case RENDER_CLEAR:
+        canvas_fill_rect_clip(canvas, clip, (ivec2){clip.x0, clip.y0}, (ivec2){clip.x1, clip.y1}, command->clear.color);
+        break;
+    case RENDER_RECT:
+        canvas_fill_rect_clip(canvas, clip, command->rect.min, command->rect.max, command->rect.color);
+        break;
+    case RENDER_LINE:
+        canvas_draw_line_clip(canvas, clip, command->line.a, command->line.b, command->line.color);
+        break;
+    case RENDER_TRIANGLE:
+        canvas_fill_triangle_clip(canvas, clip, command->triangle.p[0], command->triangle.p[1], command->triangle.p[2],
+                                  command->triangle.c[0], command->triangle.c[1], command->triangle.c[2]);
+        break;
+    case RENDER_BLIT:
+        canvas_blit_clip(canvas, clip, command->blit.pos, command->blit.pixels, command->blit.width, command->blit.height);
+        break;
+    }
+}
+
+static Clip_Rect render_tile_rect(const Render_Pool* pool, int tile) {
+    int tx = tile % pool->tiles_x, band = tile / pool->tiles_x;
+    Clip_Rect r = {
+        .x0 = tx * RENDER_TILE_WIDTH,
+        .y0 = band * pool->band_height,
+        .x1 = (tx + 1) * RENDER_TILE_WIDTH,
+        .y1 = (band + 1) * pool->band_height,
+    };
+    return raster_intersect(r, canvas_rect(pool->canvas));
+}
+
+static void render_tile(Render_Pool* pool, int tile) {
+    Clip_Rect clip = render_tile_rect(pool, tile);
+    const Render_Command* commands = pool->list->commands;
+    for (int i = pool->bin_offsets[tile]; i < pool->bin_offsets[tile + 1]; i++) {
+        render_command(pool->canvas, clip, &commands[pool->bin_commands[i]]);
+    }
+}
+
+static void render_unit(Render_Pool* pool, int unit) {
+    if (pool->tile_units) {
+        render_tile(pool, unit);
+        return;
+    }
+    for (int tx = 0; tx < pool->tiles_x; tx++) {
+        render_tile(pool, unit * pool->tiles_x + tx);
+    }
+}
+
+#define RENDER_RANGE(next, end) ((uint64_t)(uint32_t)(next) | ((uint64_t)(uint32_t)(end) << 32))
+
+static bool render_take_own(Render_Queue* queue, int* unit) {
+    uint64_t range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (next >= end) return false;
+        if (__atomic_compare_exchange_n(&queue->range, &range, RENDER_RANGE(next + 1, end), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *unit = (int)next;
+            return true;
+        }
+    }
+}
+
+// takes the back half of another thread's run into our own (empty) queue
+static bool render_steal(Render_Pool* pool, int self) {
+    for (int k = 1; k < pool->thread_count; k++) {
+        Render_Queue* victim = &pool->queues[(self + k) % pool->thread_count];
+        uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+            if (next >= end) break;
+            uint32_t middle = end - (end - next + 1) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &range, RENDER_RANGE(next, middle), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                // units never come back once taken, so nobody can still expect an old value of our queue here
+                __atomic_store_n(&pool->queues[self].range, RENDER_RANGE(middle, end), __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void render_work(Render_Pool* pool, int self) {
+    int unit;
+    do {
+        while (render_take_own(&pool->queues[self], &unit)) {
+            render_unit(pool, unit);
+        }
+    } while (render_steal(pool, self));
+}
+
+typedef struct {
+    Render_Pool* pool;
+    int index;
+} Render_Worker;
+
+static void* render_worker_thread(void* arg) {
+    Render_Worker worker = *(Render_Worker*)arg;
+    free(arg);
+    Render_Pool* pool = worker.pool;
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        render_work(pool, worker.index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+bool render_pool_init(Render_Pool* pool, int thread_count) {
+    memset(pool, 0, sizeof(*pool));
+    if (thread_count <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (int)(cores > 0 ? cores : 1);
+    }
+
+    pool->queues = (Render_Queue*)aligned_alloc(64, thread_count * sizeof(Render_Queue));
+    pool->threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (!pool->queues || !pool->threads) {
+        fprintf(stderr, "Memory allocation failure creating a render pool with %d threads\n", thread_count);
+        free(pool->queues);
+        free(pool->threads);
+        memset(pool, 0, sizeof(*pool));
+        return false;
+    }
+    memset(pool->queues, 0, thread_count * sizeof(Render_Queue));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // the calling thread is worker 0, with fewer threads than asked for the pool still works
+    pool->thread_count = 1;
+    for (int i = 1; i < thread_count; i++) {
+        Render_Worker* worker = (Render_Worker*)malloc(sizeof(Render_Worker));
+        if (!worker) break;
+        *worker = (Render_Worker){.pool = pool, .index = i};
+        if (pthread_create(&pool->threads[i], NULL, render_worker_thread, worker) != 0) {
+            fprintf(stderr, "Could not start render thread %d of %d\n", i, thread_count);
+            free(worker);
+            break;
+        }
+        pool->thread_count++;
+    }
+    return true;
+}
+
+void render_pool_free(Render_Pool* pool) {
+    if (!pool->queues) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->queues);
+    free(pool->threads);
+    free(pool->bin_offsets);
+    free(pool->bin_commands);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static void render_reserve(int** data, int* capacity, int needed) {
+    if (needed <= *capacity) return;
+    int grown = *capacity * 2 > needed ? *capacity * 2 : needed;
+    int* memory = (int*)realloc(*data, grown * sizeof(int));
+    if (!memory) panic("Memory allocation failure");
+    *data = memory;
+    *capacity = grown;
+}
+
+// counting sort of the commands into the tiles their bounds touch, in submission order
+static void render_bin(Render_Pool* pool) {
+    int tile_count = pool->tiles_x * pool->bands;
+    render_reserve(&pool->bin_offsets, &pool->bin_tile_capacity, tile_count + 1);
+    int* offsets = pool->bin_offsets;
+    memset(offsets, 0, (tile_count + 1) * sizeof(int));
+
+    const Render_List* list = pool->list;
+    Clip_Rect all = canvas_rect(pool->canvas);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < list->count; i++) {
+            Clip_Rect b = raster_intersect(list->commands[i].bounds, all);
+            if (b.x0 == b.x1 || b.y0 == b.y1) continue;
+            int tx0 = b.x0 / RENDER_TILE_WIDTH, tx1 = (b.x1 - 1) / RENDER_TILE_WIDTH;
+            int band0 = b.y0 / pool->band_height, band1 = (b.y1 - 1) / pool->band_height;
+            for (int band = band0; band <= band1; band++) {
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    int tile = band * pool->tiles_x + tx;
+                    if (pass == 0) offsets[tile + 1]++;
+                    else pool->bin_commands[offsets[tile]++] = i;
+                }
+            }
+        }
+
+        if (pass == 0) {
+            // counts to starts, the second pass then moves the start of every tile to its end
+            for (int t = 0; t < tile_count; t++) {
+                offsets[t + 1] += offsets[t];
+            }
+            render_reserve(&pool->bin_commands, &pool->bin_command_capacity, offsets[tile_count]);
+        }
+    }
+    memmove(offsets + 1, offsets, tile_count * sizeof(int));
+    offsets[0] = 0;
+}
+
+void render_list_draw(Canvas canvas, const Render_List* list, Render_Pool* pool) {
+    if (!pool || !pool->queues) {
+        Clip_Rect all = canvas_rect(canvas);
+        for (int i = 0; i < list->count; i++) {
+            render_command(canvas, all, &list->commands[i]);
+        }
+        return;
+    }
+    if (canvas.width <= 0 || canvas.height <= 0 || list->count == 0) return;
+
+    // a band starts on a cache line when band_height rows are a multiple of 64 bytes
+    int row_bytes = canvas.width * (int)sizeof(rgb_t);
+    int lowest_bit = row_bytes & -row_bytes;
+    int rows_per_line = lowest_bit >= 64 ? 1 : 64 / lowest_bit;
+    pool->canvas = canvas;
+    pool->list = list;
+    pool->tiles_x = (canvas.width + RENDER_TILE_WIDTH - 1) / RENDER_TILE_WIDTH;
+    pool->band_height = (RENDER_TILE_HEIGHT + rows_per_line - 1) / rows_per_line * rows_per_line;
+    pool->bands = (canvas.height + pool->band_height - 1) / pool->band_height;
+    pool->tile_units = rows_per_line == 1;
+    render_bin(pool);
+
+    int units = pool->tile_units ? pool->tiles_x * pool->bands : pool->bands;
+    for (int t = 0; t < pool->thread_count; t++) {
+        int first = (int)((int64_t)units * t / pool->thread_count);
+        int last = (int)((int64_t)units * (t + 1) / pool->thread_count);
+        __atomic_store_n(&pool->queues[t].range, RENDER_RANGE(first, last), __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->running = pool->thread_count - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    render_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#undef RENDER_RANGE
+
+#endif // RENDER_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _RENDER
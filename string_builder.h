@@ -14,7 +14,15 @@ extern "C" {
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
+#include <math.h>
+
+// the arena backed builders and lists need the arena, its implementation comes with this one
+#ifdef STRING_BUILDER_IMPLEMENTATION
+#define ARENA_IMPLEMENTATION
+#endif // STRING_BUILDER_IMPLEMENTATION
+#include "arena.h"
 
 #define CSTRING_LENGTH(s) (sizeof(s)-1)
 #define TO_STRING(s) ((String){.data = s, .size = CSTRING_LENGTH(s)})
@@ -38,19 +46,104 @@ typedef struct {
     String* data;
     int size;
     int cap;
+    Arena* arena;  // NULL if the list owns its memory
 } String_List;
 
 String_List make_string_list(int init_cap);
+String_List make_string_list_arena(Arena* arena, int init_cap);
 void string_list_append(String_List* list, String s);
+
+// set of delimiter bytes for the multi-delimiter split variants
+// the scanners behind split pick between sse2/avx2 and a scalar loop at runtime, define STRING_NO_SIMD to always use the scalar loop
+#define BYTE_SET_COMPARE_MAX 8
+
+typedef struct {
+    uint64_t bits[4];                         // membership, one bit per byte value
+    unsigned char bytes[BYTE_SET_COMPARE_MAX];  // members, only valid if count <= BYTE_SET_COMPARE_MAX
+    unsigned char nibbles[16];                // low nibble -> mask of high nibbles, only valid if ascii
+    int count;
+    bool ascii;                               // all members are below 0x80
+} Byte_Set;
+
+typedef enum {
+    CHAR_CLASS_WHITESPACE,  // ' ', '\t', '\n', '\v', '\f', '\r'
+    CHAR_CLASS_DIGIT,
+    CHAR_CLASS_ALPHA,
+    CHAR_CLASS_ALNUM,
+    CHAR_CLASS_PUNCT,
+} Char_Class;
+
+Byte_Set make_byte_set(const char* bytes);
+Byte_Set make_byte_set_class(Char_Class char_class);
+void byte_set_add(Byte_Set* set, char c);
+bool byte_set_contains(const Byte_Set* set, char c);
+
+int find_byte(String s, int start, char c);                    // index of the first c at or after start, s.size if there is none
+int find_byte_set(String s, int start, const Byte_Set* set);  // same as find_byte but for any member of the set
+
 String_List split(String s, char delimeter);
+String_List split_any(String s, const char* delimeters);  // splits on any of the bytes in the null terminated delimeters
+String_List split_set(String s, const Byte_Set* set);
+String_List split_class(String s, Char_Class char_class);
+String_List split_arena(Arena* arena, String s, char delimeter);
+
+typedef int (*Byte_Scanner)(const char* data, int size, int start, const Byte_Set* set);
+
+// number parsing on string views, nothing is allocated and the input does not need to be null terminated
+// parsing starts at the first byte (no whitespace skipping) and stops at the first byte that cannot continue the number
+typedef enum {
+    PARSE_OK,
+    PARSE_INVALID,   // the string does not start with a number
+    PARSE_OVERFLOW,  // the number does not fit, the result is clamped to the closest representable value
+} Parse_Status;
+
+typedef struct {
+    Parse_Status status;
+    int consumed;  // bytes that make up the number, 0 if invalid
+} Parse_Result;
+
+Parse_Result parse_u32(String s, uint32_t* out);
+Parse_Result parse_i32(String s, int32_t* out);
+Parse_Result parse_u64(String s, uint64_t* out);
+Parse_Result parse_i64(String s, int64_t* out);
+Parse_Result parse_hex_u64(String s, uint64_t* out);  // optional 0x prefix
+Parse_Result parse_double(String s, double* out);     // decimal with optional fraction and exponent, inf, infinity and nan
+
+// yields the same fields as split one at a time, without allocating
+// in streaming mode the chunks are fed one after another and a field that crosses a chunk boundary is
+// assembled in the caller provided carry buffer, the returned view is valid until the next call to split_iterator_next
+typedef struct {
+    String input;
+    int cursor;
+    Byte_Set delimeters;
+    Byte_Scanner scan;
+    bool streaming;
+    bool ended;           // no more chunks will be fed
+    bool done;
+    bool carry_overflow;  // a field did not fit the carry buffer and was truncated
+    char* carry;
+    int carry_size;
+    int carry_capacity;
+} String_Split_Iterator;
+
+void split_iterator_init(String_Split_Iterator* it, String s, char delimeter);
+void split_iterator_init_set(String_Split_Iterator* it, String s, const Byte_Set* set);
+void split_iterator_init_stream(String_Split_Iterator* it, const Byte_Set* set, char* carry_buffer, int carry_capacity);
+void split_iterator_feed(String_Split_Iterator* it, String chunk);  // the previous chunk must be exhausted
+void split_iterator_end(String_Split_Iterator* it);                 // the carried partial field becomes the last one
+// returns false when the iterator is done or, in streaming mode, when the current chunk is exhausted
+bool split_iterator_next(String_Split_Iterator* it, String* field);
+bool split_iterator_done(String_Split_Iterator* it);
 
 typedef struct {
     char* buffer;
     int buffer_capacity;
     int cursor;
+    Arena* arena;  // NULL if the builder owns its buffer
 } String_Builder;
 
 String_Builder make_string_builder(int initial_capacity);
+String_Builder make_string_builder_arena(Arena* arena, int initial_capacity);  // sb_free is a no op, the arena releases the buffer
 void sb_append(String_Builder* sb, String string);
 void sb_append_char(String_Builder* sb, char ch);
 const char* sb_to_c_string(String_Builder* sb);
@@ -59,6 +152,14 @@ void sb_append_many(String_Builder* sb, String* strings, int n);
 void sb_free(String_Builder* sb);
 void sb_clear(String_Builder* sb);
 
+// numeric formatting straight into the builder
+void sb_append_int(String_Builder* sb, int n);
+void sb_append_uint(String_Builder* sb, unsigned int n);
+void sb_append_i64(String_Builder* sb, int64_t n);
+void sb_append_u64(String_Builder* sb, uint64_t n);
+// shortest representation that reads back to the same double (grisu2), "nan", "inf" and "-inf" for the special values
+void sb_append_double(String_Builder* sb, double n);
+
 #ifdef STRING_BUILDER_IMPLEMENTATION
 
 String make_string(const char* s) {
@@ -148,6 +249,7 @@ String_Builder make_string_builder(int initial_capacity) {
         .buffer = NULL,
         .buffer_capacity = 0,
         .cursor = 0,
+        .arena = NULL,
     };
 
     sb.buffer = (char*)malloc(initial_capacity);
@@ -157,7 +259,25 @@ String_Builder make_string_builder(int initial_capacity) {
     return sb;
 }
 
+String_Builder make_string_builder_arena(Arena* arena, int initial_capacity) {
+    String_Builder sb = (String_Builder) {
+        .buffer = (char*)arena_push(arena, initial_capacity),
+        .buffer_capacity = initial_capacity,
+        .cursor = 0,
+        .arena = arena,
+    };
+
+    sb.buffer[0] = '\0';
+    return sb;
+}
+
 void sb_resize(String_Builder* sb) {
+    if (sb->arena) {
+        sb->buffer = (char*)arena_resize(sb->arena, sb->buffer, sb->cursor, sb->buffer_capacity * 2);
+        sb->buffer_capacity *= 2;
+        return;
+    }
+
     char* nbuff = (char*)malloc(sb->buffer_capacity * 2 * sizeof(char));
     memcpy(nbuff, sb->buffer, sb->cursor);
     free(sb->buffer);
@@ -219,7 +339,7 @@ const char* sb_to_c_string(String_Builder* sb) {
 }
 
 void sb_free(String_Builder* sb) {
-    free(sb->buffer);
+    if (!sb->arena) free(sb->buffer);
     sb->cursor = 0;
     sb->buffer_capacity = 0;
     sb->buffer = NULL;
@@ -230,28 +350,930 @@ void sb_clear(String_Builder* sb) {
     sb->buffer[0] = '\0';
 }
 
-String_List split(String string, char delimeter) {
-    String_List list = make_string_list(string.size / 10);  // careful with allocation on large inputs
+static const char decimal_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static int decimal_digit_count(uint64_t n) {
+    int count = 1;
+    for (;;) {
+        if (n < 10) return count;
+        if (n < 100) return count + 1;
+        if (n < 1000) return count + 2;
+        if (n < 10000) return count + 3;
+        n /= 10000;
+        count += 4;
+    }
+}
+
+// writes exactly digit_count digits ending right before end
+static void write_decimal_digits(char* end, uint64_t n) {
+    while (n >= 100) {
+        const char* pair = decimal_digit_pairs + (n % 100) * 2;
+        n /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+
+    if (n >= 10) {
+        const char* pair = decimal_digit_pairs + n * 2;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    else {
+        *--end = (char)('0' + n);
+    }
+}
+
+static void sb_append_decimal(String_Builder* sb, uint64_t n, bool negative) {
+    int count = decimal_digit_count(n) + negative;
+    sb_grow_to_size(sb, sb->cursor + count);
+
+    char* out = sb->buffer + sb->cursor;
+    if (negative) out[0] = '-';
+    write_decimal_digits(out + count, n);
+    sb->cursor += count;
+}
+
+void sb_append_u64(String_Builder* sb, uint64_t n) {
+    sb_append_decimal(sb, n, false);
+}
+
+void sb_append_i64(String_Builder* sb, int64_t n) {
+    // negate in unsigned so INT64_MIN does not overflow
+    sb_append_decimal(sb, n < 0 ? 0 - (uint64_t)n : (uint64_t)n, n < 0);
+}
+
+void sb_append_uint(String_Builder* sb, unsigned int n) {
+    sb_append_decimal(sb, n, false);
+}
+
+void sb_append_int(String_Builder* sb, int n) {
+    sb_append_i64(sb, n);
+}
+
+// grisu2 as described in "Printing Floating-Point Numbers Quickly and Accurately with Integers" (Loitsch 2010)
+// the output always reads back to the same double and is the shortest one for the vast majority of inputs
+
+typedef struct {
+    uint64_t f;
+    int e;
+} Diy_Fp;
+
+static const uint64_t grisu_cached_powers_f[87] = {
+    0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull, 0xcf42894a5dce35eaull,
+    0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull, 0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full,
+    0xbe5691ef416bd60cull, 0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+    0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull, 0xc21094364dfb5637ull,
+    0x9096ea6f3848984full, 0xd77485cb25823ac7ull, 0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull,
+    0xb23867fb2a35b28eull, 0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+    0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull, 0xb5b5ada8aaff80b8ull,
+    0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull, 0x964e858c91ba2655ull, 0xdff9772470297ebdull,
+    0xa6dfbd9fb8e5b88full, 0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+    0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull, 0xaa242499697392d3ull,
+    0xfd87b5f28300ca0eull, 0xbce5086492111aebull, 0x8cbccc096f5088ccull, 0xd1b71758e219652cull,
+    0x9c40000000000000ull, 0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+    0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull, 0x9f4f2726179a2245ull,
+    0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull, 0x83c7088e1aab65dbull, 0xc45d1df942711d9aull,
+    0x924d692ca61be758ull, 0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+    0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull, 0x952ab45cfa97a0b3ull,
+    0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull, 0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull,
+    0x88fcf317f22241e2ull, 0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+    0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull, 0x8bab8eefb6409c1aull,
+    0xd01fef10a657842cull, 0x9b10a4e5e9913129ull, 0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull,
+    0x80444b5e7aa7cf85ull, 0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+    0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull,
+};
+
+static const int16_t grisu_cached_powers_e[87] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901, -874, -847, -821,
+    -794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502, -475, -449, -422, -396,
+    -369, -343, -316, -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t grisu_pow10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+static Diy_Fp diy_fp_multiply(Diy_Fp x, Diy_Fp y) {
+    const uint64_t mask32 = 0xffffffffull;
+    uint64_t a = x.f >> 32, b = x.f & mask32;
+    uint64_t c = y.f >> 32, d = y.f & mask32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    tmp += 1ull << 31;  // round
+    return (Diy_Fp){.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), .e = x.e + y.e + 64};
+}
+
+static Diy_Fp diy_fp_normalize(Diy_Fp x) {
+    int shift = __builtin_clzll(x.f);
+    return (Diy_Fp){.f = x.f << shift, .e = x.e - shift};
+}
+
+static void grisu_round(char* buffer, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int grisu_digit_gen(Diy_Fp w, Diy_Fp mp, uint64_t delta, char* buffer, int* k) {
+    Diy_Fp one = (Diy_Fp){.f = 1ull << -mp.e, .e = mp.e};
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = decimal_digit_count(p1);
+    int length = 0;
+
+    while (kappa > 0) {
+        uint32_t d;
+        switch (kappa) {  // constant divisors so the compiler can turn them into multiplications
+        case 10: d = p1 / 1000000000; p1 %= 1000000000; break;
+        case 9:  d = p1 / 100000000;  p1 %= 100000000;  break;
+        case 8:  d = p1 / 10000000;   p1 %= 10000000;   break;
+        case 7:  d = p1 / 1000000;    p1 %= 1000000;    break;
+        case 6:  d = p1 / 100000;     p1 %= 100000;     break;
+        case 5:  d = p1 / 10000;      p1 %= 10000;      break;
+        case 4:  d = p1 / 1000;       p1 %= 1000;       break;
+        case 3:  d = p1 / 100;        p1 %= 100;        break;
+        case 2:  d = p1 / 10;         p1 %= 10;         break;
+        default: d = p1;              p1 = 0;           break;
+        }
+        if (d || length) buffer[length++] = (char)('0' + d);
+        kappa--;
+
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            grisu_round(buffer, length, delta, rest, grisu_pow10[kappa] << -one.e, wp_w);
+            return length;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || length) buffer[length++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            grisu_round(buffer, length, delta, p2, one.f, wp_w * grisu_pow10[-kappa]);
+            return length;
+        }
+    }
+}
+
+// writes the digits of a positive finite double and the decimal exponent k so that value = digits * 10^k
+static int grisu2(double value, char* buffer, int* k) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t hidden_bit = 1ull << 52;
+    int biased_e = (int)((bits >> 52) & 0x7ff);
+    uint64_t significand = bits & (hidden_bit - 1);
+
+    Diy_Fp v;
+    if (biased_e) {
+        v = (Diy_Fp){.f = significand + hidden_bit, .e = biased_e - 1075};
+    }
+    else {
+        v = (Diy_Fp){.f = significand, .e = -1074};
+    }
+
+    // boundaries halfway to the neighbouring doubles, the lower one is closer when v is a power of two
+    Diy_Fp plus = diy_fp_normalize((Diy_Fp){.f = (v.f << 1) + 1, .e = v.e - 1});
+    Diy_Fp minus = (v.f == hidden_bit) ? (Diy_Fp){.f = (v.f << 2) - 1, .e = v.e - 2}
+                                       : (Diy_Fp){.f = (v.f << 1) - 1, .e = v.e - 1};
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // cached power of ten that brings the exponent of plus into [-60, -32]
+    double dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    if (dk - ik > 0.0) ik++;
+    int index = (ik >> 3) + 1;
+    *k = -(-348 + index * 8);
+    Diy_Fp c_mk = (Diy_Fp){.f = grisu_cached_powers_f[index], .e = grisu_cached_powers_e[index]};
+
+    Diy_Fp w = diy_fp_multiply(diy_fp_normalize(v), c_mk);
+    Diy_Fp wp = diy_fp_multiply(plus, c_mk);
+    Diy_Fp wm = diy_fp_multiply(minus, c_mk);
+    wm.f++;
+    wp.f--;
+    return grisu_digit_gen(w, wp, wp.f - wm.f, buffer, k);
+}
+
+// lays out length digits with decimal exponent k in place, returns the new length
+// plain notation for 1e-6 <= value < 1e21, scientific otherwise
+static int format_decimal_exponent(char* buffer, int length, int k) {
+    int kk = length + k;  // 10^(kk-1) <= value < 10^kk
+
+    if (length <= kk && kk <= 21) {
+        for (int i = length; i < kk; i++) buffer[i] = '0';
+        return kk;
+    }
+    if (0 < kk && kk <= 21) {
+        memmove(buffer + kk + 1, buffer + kk, length - kk);
+        buffer[kk] = '.';
+        return length + 1;
+    }
+    if (-6 < kk && kk <= 0) {
+        int offset = 2 - kk;
+        memmove(buffer + offset, buffer, length);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        for (int i = 2; i < offset; i++) buffer[i] = '0';
+        return length + offset;
+    }
+
+    int cursor = 1;
+    if (length > 1) {
+        memmove(buffer + 2, buffer + 1, length - 1);
+        buffer[1] = '.';
+        cursor = length + 1;
+    }
+    buffer[cursor++] = 'e';
+
+    int exponent = kk - 1;
+    if (exponent < 0) {
+        buffer[cursor++] = '-';
+        exponent = -exponent;
+    }
+    int digits = decimal_digit_count((uint64_t)exponent);
+    write_decimal_digits(buffer + cursor + digits, (uint64_t)exponent);
+    return cursor + digits;
+}
+
+void sb_append_double(String_Builder* sb, double n) {
+    if (isnan(n)) {
+        sb_append(sb, TO_STRING("nan"));
+        return;
+    }
+    if (isinf(n)) {
+        sb_append(sb, n < 0 ? TO_STRING("-inf") : TO_STRING("inf"));
+        return;
+    }
+
+    // longest output is a sign, 17 digits, a point and leading zeros or an exponent
+    sb_grow_to_size(sb, sb->cursor + 32);
+    char* out = sb->buffer + sb->cursor;
+    int length = 0;
+    if (signbit(n)) {
+        out[length++] = '-';
+        n = -n;
+    }
+
+    if (n == 0) {
+        out[length++] = '0';
+    }
+    else {
+        int k;
+        int digits = grisu2(n, out + length, &k);
+        length += format_decimal_exponent(out + length, digits, k);
+    }
+
+    sb->cursor += length;
+}
+
+// eight ascii digits are parsed at once as a little endian 64 bit word
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PARSE_SWAR
+#endif
+
+#ifdef PARSE_SWAR
+
+// index of the first byte that is not a digit in the word, 8 if all of them are
+static int swar_digit_prefix(uint64_t v) {
+    uint64_t t = (v & 0xf0f0f0f0f0f0f0f0ull) | (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4);
+    t ^= 0x3333333333333333ull;
+    return t ? __builtin_ctzll(t) >> 3 : 8;
+}
+
+static uint64_t swar_parse_eight_digits(uint64_t v) {
+    const uint64_t mask = 0x000000ff000000ffull;
+    const uint64_t mul1 = 100 + (1000000ull << 32);
+    const uint64_t mul2 = 1 + (10000ull << 32);
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);
+    return (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+}
+
+#endif // PARSE_SWAR
+
+static bool is_digit(char c) {
+    return '0' <= c && c <= '9';
+}
+
+// length of the run of decimal digits at the start of data
+static int digit_run(const char* data, int size) {
+    int i = 0;
+#ifdef PARSE_SWAR
+    while (size - i >= 8) {
+        uint64_t v;
+        memcpy(&v, data + i, sizeof(v));
+        int n = swar_digit_prefix(v);
+        i += n;
+        if (n < 8) return i;
+    }
+#endif // PARSE_SWAR
+    while (i < size && is_digit(data[i])) i++;
+    return i;
+}
+
+// value of n digits, n must be at most 19 so that it can not overflow
+static uint64_t parse_digits(const char* data, int n) {
+    uint64_t v = 0;
+    int i = 0;
+#ifdef PARSE_SWAR
+    for (; n - i >= 8; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        v = v * 100000000 + swar_parse_eight_digits(word);
+    }
+#endif // PARSE_SWAR
+    for (; i < n; i++) {
+        v = v * 10 + (uint64_t)(data[i] - '0');
+    }
+    return v;
+}
+
+// unsigned decimal magnitude starting at start, consumed is relative to the start of s
+static Parse_Result parse_decimal_magnitude(String s, int start, uint64_t* out) {
+    const char* data = s.data + start;
+    int size = s.size - start;
+    uint64_t v = 0;
+    int i = 0;
+
+#ifdef PARSE_SWAR
+    // up to 19 digits can not overflow, so the first 16 go through without checks
+    while (size - i >= 8 && i <= 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        int n = swar_digit_prefix(word);
+        if (n < 8) {
+            // move the digits to the end of the number and pad the front with '0's
+            if (n) {
+                int shift = 8 * (8 - n);
+                word = (word << shift) | (0x3030303030303030ull >> (64 - shift));
+                v = v * grisu_pow10[n] + swar_parse_eight_digits(word);
+                i += n;
+            }
+            break;
+        }
+        v = v * 100000000 + swar_parse_eight_digits(word);
+        i += 8;
+    }
+#endif // PARSE_SWAR
+
+    bool overflow = false;
+    for (; i < size && is_digit(data[i]); i++) {
+        uint64_t d = (uint64_t)(data[i] - '0');
+        if (__builtin_mul_overflow(v, 10, &v) || __builtin_add_overflow(v, d, &v)) {
+            overflow = true;
+        }
+    }
+
+    if (i == 0) return (Parse_Result){.status = PARSE_INVALID, .consumed = 0};
+
+    *out = overflow ? UINT64_MAX : v;
+    return (Parse_Result){.status = overflow ? PARSE_OVERFLOW : PARSE_OK, .consumed = start + i};
+}
+
+// parses an optionally signed decimal and clamps it into [-negative_limit, positive_limit]
+static Parse_Result parse_signed(String s, uint64_t positive_limit, uint64_t negative_limit, bool* negative, uint64_t* magnitude) {
     int start = 0;
-    for (int i = 0; i < string.size; i++) {
-        if (string.data[i] == delimeter) {
-            String s = (String){.data = string.data + start, .size = i - start};
-            string_list_append(&list, s);
-            start = i + 1;
+    *negative = false;
+    if (s.size > 0 && (s.data[0] == '+' || s.data[0] == '-')) {
+        *negative = s.data[0] == '-';
+        start = 1;
+    }
+
+    Parse_Result result = parse_decimal_magnitude(s, start, magnitude);
+    if (result.status == PARSE_INVALID) return result;
+
+    uint64_t limit = *negative ? negative_limit : positive_limit;
+    if (*magnitude > limit) {
+        *magnitude = limit;
+        result.status = PARSE_OVERFLOW;
+    }
+    return result;
+}
+
+Parse_Result parse_u64(String s, uint64_t* out) {
+    bool negative;
+    uint64_t v = 0;
+    Parse_Result result = parse_signed(s, UINT64_MAX, 0, &negative, &v);
+    if (result.status != PARSE_INVALID) *out = v;
+    return result;
+}
+
+Parse_Result parse_u32(String s, uint32_t* out) {
+    bool negative;
+    uint64_t v = 0;
+    Parse_Result result = parse_signed(s, UINT32_MAX, 0, &negative, &v);
+    if (result.status != PARSE_INVALID) *out = (uint32_t)v;
+    return result;
+}
+
+Parse_Result parse_i64(String s, int64_t* out) {
+    bool negative;
+    uint64_t v = 0;
+    Parse_Result result = parse_signed(s, INT64_MAX, (uint64_t)INT64_MAX + 1, &negative, &v);
+    if (result.status != PARSE_INVALID) *out = negative ? (int64_t)(0 - v) : (int64_t)v;
+    return result;
+}
+
+Parse_Result parse_i32(String s, int32_t* out) {
+    bool negative;
+    uint64_t v = 0;
+    Parse_Result result = parse_signed(s, INT32_MAX, (uint64_t)INT32_MAX + 1, &negative, &v);
+    if (result.status != PARSE_INVALID) *out = negative ? (int32_t)(0 - (int64_t)v) : (int32_t)v;
+    return result;
+}
+
+static int hex_digit_value(char c) {
+    if ('0' <= c && c <= '9') return c - '0';
+    if ('a' <= c && c <= 'f') return c - 'a' + 10;
+    if ('A' <= c && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+Parse_Result parse_hex_u64(String s, uint64_t* out) {
+    int i = 0;
+    if (s.size > 2 && s.data[0] == '0' && (s.data[1] == 'x' || s.data[1] == 'X') && hex_digit_value(s.data[2]) >= 0) {
+        i = 2;
+    }
+
+    int start = i;
+    uint64_t v = 0;
+    bool overflow = false;
+    for (; i < s.size; i++) {
+        int d = hex_digit_value(s.data[i]);
+        if (d < 0) break;
+        if (v >> 60) overflow = true;
+        v = (v << 4) | (uint64_t)d;
+    }
+
+    if (i == start) return (Parse_Result){.status = PARSE_INVALID, .consumed = 0};
+
+    *out = overflow ? UINT64_MAX : v;
+    return (Parse_Result){.status = overflow ? PARSE_OVERFLOW : PARSE_OK, .consumed = i};
+}
+
+static bool match_word_nocase(String s, int start, const char* word) {
+    int n = string_length(word);
+    if (s.size - start < n) return false;
+    for (int i = 0; i < n; i++) {
+        char c = s.data[start + i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != word[i]) return false;
+    }
+    return true;
+}
+
+Parse_Result parse_double(String s, double* out) {
+    static const double exact_pow10[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    int i = 0;
+    bool negative = false;
+    if (s.size > 0 && (s.data[0] == '+' || s.data[0] == '-')) {
+        negative = s.data[0] == '-';
+        i = 1;
+    }
+
+    if (match_word_nocase(s, i, "inf")) {
+        *out = negative ? -INFINITY : INFINITY;
+        int n = match_word_nocase(s, i, "infinity") ? 8 : 3;
+        return (Parse_Result){.status = PARSE_OK, .consumed = i + n};
+    }
+    if (match_word_nocase(s, i, "nan")) {
+        *out = negative ? -NAN : NAN;
+        return (Parse_Result){.status = PARSE_OK, .consumed = i + 3};
+    }
+
+    const char* int_digits = s.data + i;
+    int int_len = digit_run(int_digits, s.size - i);
+    i += int_len;
+
+    const char* frac_digits = s.data + i;
+    int frac_len = 0;
+    if (i < s.size && s.data[i] == '.') {
+        frac_digits = s.data + i + 1;
+        frac_len = digit_run(frac_digits, s.size - i - 1);
+        if (int_len || frac_len) i += 1 + frac_len;
+    }
+
+    if (int_len + frac_len == 0) return (Parse_Result){.status = PARSE_INVALID, .consumed = 0};
+
+    int exponent = 0;
+    if (i < s.size && (s.data[i] == 'e' || s.data[i] == 'E')) {
+        int j = i + 1;
+        bool exponent_negative = false;
+        if (j < s.size && (s.data[j] == '+' || s.data[j] == '-')) {
+            exponent_negative = s.data[j] == '-';
+            j++;
+        }
+
+        int exponent_len = digit_run(s.data + j, s.size - j);
+        if (exponent_len) {
+            for (int k = 0; k < exponent_len; k++) {
+                if (exponent < 100000) exponent = exponent * 10 + (s.data[j + k] - '0');
+            }
+            if (exponent_negative) exponent = -exponent;
+            i = j + exponent_len;
+        }
+    }
+
+    // significant digits, leading zeros of the integer part and then of the fraction if the integer part is zero
+    while (int_len && *int_digits == '0') {
+        int_digits++;
+        int_len--;
+    }
+    if (int_len == 0) {
+        while (frac_len && *frac_digits == '0') {
+            frac_digits++;
+            frac_len--;
+            exponent--;
+        }
+    }
+
+    // exact when the digits fit in the 53 bit mantissa and the power of ten is exact as well (Clinger's fast path)
+    if (int_len + frac_len <= 19) {
+        uint64_t mantissa = parse_digits(int_digits, int_len);
+        mantissa = mantissa * grisu_pow10[frac_len] + parse_digits(frac_digits, frac_len);
+        int exp10 = exponent - frac_len;
+
+        if (mantissa == 0) {
+            *out = negative ? -0.0 : 0.0;
+            return (Parse_Result){.status = PARSE_OK, .consumed = i};
+        }
+        if (mantissa <= (1ull << 53) && -22 <= exp10 && exp10 <= 22) {
+            double v = (double)mantissa;
+            v = exp10 < 0 ? v / exact_pow10[-exp10] : v * exact_pow10[exp10];
+            *out = negative ? -v : v;
+            return (Parse_Result){.status = PARSE_OK, .consumed = i};
+        }
+    }
+
+    // slow path, strtod on a null terminated copy of the significant digits and the exponent
+    // correct rounding never needs more than 768 significant digits, past 800 of them a nonzero tail only
+    // matters as a 1 that breaks a tie, so the copy has a fixed size however long the span is
+    enum { PARSE_MAX_DIGITS = 800 };
+    char copy[PARSE_MAX_DIGITS + 32];
+    int n = 0;
+    int digits = int_len + frac_len;
+    int kept = digits < PARSE_MAX_DIGITS ? digits : PARSE_MAX_DIGITS;
+    if (negative) copy[n++] = '-';
+    for (int k = 0; k < kept; k++) {
+        copy[n++] = k < int_len ? int_digits[k] : frac_digits[k - int_len];
+    }
+    long long exp10 = (long long)exponent - frac_len + (digits - kept);
+    for (int k = kept; k < digits; k++) {
+        char c = k < int_len ? int_digits[k] : frac_digits[k - int_len];
+        if (c != '0') {
+            copy[n++] = '1';
+            exp10--;
+            break;
+        }
+    }
+    if (exp10 > 1000000) exp10 = 1000000;
+    if (exp10 < -1000000) exp10 = -1000000;
+    snprintf(copy + n, sizeof(copy) - n, "e%lld", exp10);
+    double v = strtod(copy, NULL);
+    *out = v;
+    return (Parse_Result){.status = isinf(v) ? PARSE_OVERFLOW : PARSE_OK, .consumed = i};
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(STRING_NO_SIMD)
+#define STRING_SIMD_X86
+#include <immintrin.h>
+#endif
+
+void byte_set_add(Byte_Set* set, char c) {
+    unsigned char b = (unsigned char)c;
+    if (set->bits[b >> 6] & (1ull << (b & 63))) return;
+
+    set->bits[b >> 6] |= 1ull << (b & 63);
+    if (set->count < BYTE_SET_COMPARE_MAX) {
+        set->bytes[set->count] = b;
+    }
+    set->count += 1;
+
+    if (b & 0x80) {
+        set->ascii = false;
+    }
+    else {
+        set->nibbles[b & 0x0f] |= 1 << (b >> 4);
+    }
+}
+
+bool byte_set_contains(const Byte_Set* set, char c) {
+    unsigned char b = (unsigned char)c;
+    return (set->bits[b >> 6] >> (b & 63)) & 1;
+}
+
+Byte_Set make_byte_set(const char* bytes) {
+    Byte_Set set;
+    memset(&set, 0, sizeof(set));
+    set.ascii = true;
+    for (; *bytes; bytes++) {
+        byte_set_add(&set, *bytes);
+    }
+    return set;
+}
+
+Byte_Set make_byte_set_class(Char_Class char_class) {
+    Byte_Set set = make_byte_set("");
+    for (int c = 0; c < 0x80; c++) {
+        bool digit = '0' <= c && c <= '9';
+        bool alpha = ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+        bool member = false;
+        switch (char_class) {
+        case CHAR_CLASS_WHITESPACE: member = c == ' ' || ('\t' <= c && c <= '\r'); break;
+        case CHAR_CLASS_DIGIT:      member = digit; break;
+        case CHAR_CLASS_ALPHA:      member = alpha; break;
+        case CHAR_CLASS_ALNUM:      member = digit || alpha; break;
+        case CHAR_CLASS_PUNCT:      member = c > ' ' && c < 0x7f && !digit && !alpha; break;
+        }
+        if (member) byte_set_add(&set, (char)c);
+    }
+    return set;
+}
+
+static int scan_bytes_scalar(const char* data, int size, int start, const Byte_Set* set) {
+    if (set->count == 1) {
+        const char* hit = (const char*)memchr(data + start, set->bytes[0], size - start);
+        return hit ? (int)(hit - data) : size;
+    }
+
+    for (int i = start; i < size; i++) {
+        unsigned char b = (unsigned char)data[i];
+        if ((set->bits[b >> 6] >> (b & 63)) & 1) return i;
+    }
+    return size;
+}
+
+#ifdef STRING_SIMD_X86
+
+// compares every byte against each member, only used for small sets
+__attribute__((target("sse2")))
+static int scan_bytes_sse2(const char* data, int size, int start, const Byte_Set* set) {
+    __m128i needles[BYTE_SET_COMPARE_MAX];
+    for (int k = 0; k < set->count; k++) {
+        needles[k] = _mm_set1_epi8((char)set->bytes[k]);
+    }
+
+    int i = start;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hit = _mm_cmpeq_epi8(chunk, needles[0]);
+        for (int k = 1; k < set->count; k++) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, needles[k]));
+        }
+
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    return scan_bytes_scalar(data, size, i, set);
+}
+
+__attribute__((target("avx2")))
+static int scan_bytes_avx2(const char* data, int size, int start, const Byte_Set* set) {
+    __m256i needles[BYTE_SET_COMPARE_MAX];
+    for (int k = 0; k < set->count; k++) {
+        needles[k] = _mm256_set1_epi8((char)set->bytes[k]);
+    }
+
+    int i = start;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i hit = _mm256_cmpeq_epi8(chunk, needles[0]);
+        for (int k = 1; k < set->count; k++) {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(chunk, needles[k]));
         }
+
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    return scan_bytes_sse2(data, size, i, set);
+}
+
+// classifies by nibble lookup, works for any set of ascii bytes regardless of its size
+// a byte b is in the set when nibbles[b & 0xf] has the bit (b >> 4) set, bytes >= 0x80 map to an empty mask
+__attribute__((target("avx2")))
+static int scan_bytes_avx2_nibble(const char* data, int size, int start, const Byte_Set* set) {
+    const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->nibbles));
+    const __m256i hi_table = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = start;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i lo = _mm256_and_si256(chunk, low_nibble);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_nibble);
+        __m256i classified = _mm256_and_si256(_mm256_shuffle_epi8(lo_table, lo), _mm256_shuffle_epi8(hi_table, hi));
+
+        unsigned mask = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(classified, zero));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+
+    return scan_bytes_scalar(data, size, i, set);
+}
+
+#endif  // STRING_SIMD_X86
+
+static Byte_Scanner byte_scanner_for(const Byte_Set* set) {
+#ifdef STRING_SIMD_X86
+    static int cached_cpu_level = -1;  // 0 scalar, 1 sse2, 2 avx2
+    int cpu_level = __atomic_load_n(&cached_cpu_level, __ATOMIC_RELAXED);
+    if (cpu_level < 0) {
+        __builtin_cpu_init();
+        cpu_level = __builtin_cpu_supports("avx2") ? 2 : __builtin_cpu_supports("sse2") ? 1 : 0;
+        __atomic_store_n(&cached_cpu_level, cpu_level, __ATOMIC_RELAXED);
+    }
+
+    if (set->count == 0) return scan_bytes_scalar;
+    if (cpu_level == 2) {
+        if (set->count <= 4) return scan_bytes_avx2;
+        if (set->ascii) return scan_bytes_avx2_nibble;
+        if (set->count <= BYTE_SET_COMPARE_MAX) return scan_bytes_avx2;
+    }
+    if (cpu_level >= 1 && set->count <= BYTE_SET_COMPARE_MAX) return scan_bytes_sse2;
+#else
+    (void)set;
+#endif  // STRING_SIMD_X86
+    return scan_bytes_scalar;
+}
+
+int find_byte(String s, int start, char c) {
+    Byte_Set set = make_byte_set("");
+    byte_set_add(&set, c);
+    return find_byte_set(s, start, &set);
+}
+
+int find_byte_set(String s, int start, const Byte_Set* set) {
+    if (start >= s.size) return s.size;
+    return byte_scanner_for(set)(s.data, s.size, start, set);
+}
+
+static void split_set_into(String_List* list, String string, const Byte_Set* set) {
+    Byte_Scanner scan = byte_scanner_for(set);
+    int start = 0;
+    for (;;) {
+        int i = start < string.size ? scan(string.data, string.size, start, set) : string.size;
+        String s = (String){.data = string.data + start, .size = i - start};
+        string_list_append(list, s);
+        if (i == string.size) break;
+        start = i + 1;
     }
+}
+
+String_List split_set(String string, const Byte_Set* set) {
+    String_List list = make_string_list(string.size / 10);  // careful with allocation on large inputs
+    split_set_into(&list, string, set);
+    return list;
+}
+
+String_List split(String string, char delimeter) {
+    Byte_Set set = make_byte_set("");
+    byte_set_add(&set, delimeter);
+    return split_set(string, &set);
+}
+
+String_List split_any(String string, const char* delimeters) {
+    Byte_Set set = make_byte_set(delimeters);
+    return split_set(string, &set);
+}
 
-    string_list_append(&list, (String){.data = string.data + start, .size = string.size - start});
+String_List split_class(String string, Char_Class char_class) {
+    Byte_Set set = make_byte_set_class(char_class);
+    return split_set(string, &set);
+}
 
+String_List split_arena(Arena* arena, String string, char delimeter) {
+    Byte_Set set = make_byte_set("");
+    byte_set_add(&set, delimeter);
+    String_List list = make_string_list_arena(arena, string.size / 10);
+    split_set_into(&list, string, &set);
     return list;
 }
 
+void split_iterator_init_set(String_Split_Iterator* it, String s, const Byte_Set* set) {
+    memset(it, 0, sizeof(*it));
+    it->input = s;
+    it->delimeters = *set;
+    it->scan = byte_scanner_for(set);
+}
+
+void split_iterator_init(String_Split_Iterator* it, String s, char delimeter) {
+    Byte_Set set = make_byte_set("");
+    byte_set_add(&set, delimeter);
+    split_iterator_init_set(it, s, &set);
+}
+
+void split_iterator_init_stream(String_Split_Iterator* it, const Byte_Set* set, char* carry_buffer, int carry_capacity) {
+    split_iterator_init_set(it, (String){.data = NULL, .size = 0}, set);
+    it->streaming = true;
+    it->carry = carry_buffer;
+    it->carry_capacity = carry_capacity;
+}
+
+void split_iterator_feed(String_Split_Iterator* it, String chunk) {
+    assert(it->streaming && !it->ended);
+    assert(it->cursor == it->input.size);
+    it->input = chunk;
+    it->cursor = 0;
+}
+
+void split_iterator_end(String_Split_Iterator* it) {
+    it->ended = true;
+    it->input = (String){.data = NULL, .size = 0};
+    it->cursor = 0;
+}
+
+static void split_iterator_carry(String_Split_Iterator* it, String s) {
+    int n = s.size;
+    if (it->carry_size + n > it->carry_capacity) {
+        n = it->carry_capacity - it->carry_size;
+        it->carry_overflow = true;
+    }
+    if (n <= 0) return;
+    memcpy(it->carry + it->carry_size, s.data, n);
+    it->carry_size += n;
+}
+
+bool split_iterator_next(String_Split_Iterator* it, String* field) {
+    if (it->done) return false;
+
+    String in = it->input;
+    int i = it->cursor < in.size ? it->scan(in.data, in.size, it->cursor, &it->delimeters) : in.size;
+    String s = (String){.data = in.data + it->cursor, .size = i - it->cursor};
+
+    if (i == in.size) {
+        if (it->streaming && !it->ended) {
+            // partial field, keep it until the rest of it arrives
+            split_iterator_carry(it, s);
+            it->cursor = in.size;
+            return false;
+        }
+        it->done = true;
+    }
+    it->cursor = i + 1;
+
+    if (it->carry_size) {
+        split_iterator_carry(it, s);
+        s = (String){.data = it->carry, .size = it->carry_size};
+        it->carry_size = 0;
+    }
+
+    *field = s;
+    return true;
+}
+
+bool split_iterator_done(String_Split_Iterator* it) {
+    return it->done;
+}
+
 String_List make_string_list(int init_cap) {
     int cap = MAX(8, init_cap);
     String_List list;
     list.data = malloc(cap * sizeof(String));
     list.cap = cap;
     list.size = 0;
+    list.arena = NULL;
+    return list;
+}
+
+String_List make_string_list_arena(Arena* arena, int init_cap) {
+    int cap = MAX(8, init_cap);
+    String_List list;
+    list.data = (String*)arena_push(arena, cap * sizeof(String));
+    list.cap = cap;
+    list.size = 0;
+    list.arena = arena;
     return list;
 }
 
@@ -260,10 +1282,15 @@ void string_list_append(String_List* list, String s) {
 
     if (list->size + 1 >= list->cap) {
         int new_cap = list->cap * 2;
-        String* ndata = malloc(new_cap);
-        memcpy(ndata, list->data, list->size * sizeof(String));
-        free(list->data);
-        list->data = ndata;
+        if (list->arena) {
+            list->data = (String*)arena_resize(list->arena, list->data, list->size * sizeof(String), new_cap * sizeof(String));
+        }
+        else {
+            String* ndata = malloc(new_cap * sizeof(String));
+            memcpy(ndata, list->data, list->size * sizeof(String));
+            free(list->data);
+            list->data = ndata;
+        }
         list->cap = new_cap;
     }
 
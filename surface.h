@@ -0,0 +1,434 @@
+#ifndef _SURFACE
+#define _SURFACE
+
+// images in a choice of pixel formats, for when the packed rgb of Canvas is not what the next step wants
+// rows (or rows of tiles) start on 64 byte boundaries, and the storage can be swizzled into square tiles so a
+// small block of pixels sits in a few cache lines, the planar float format keeps one plane per channel
+// conversions between formats and layouts go through avx2 kernels 8 pixels at a time when the cpu has them,
+// define SURFACE_NO_SIMD to always use the scalar loops
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "utility.h"
+
+#define SURFACE_TILE_SIZE 16  // pixels on the side of a tile
+
+typedef enum {
+    PIXEL_RGB8,
+    PIXEL_RGBA8,
+    PIXEL_RGBA_F32_PLANAR,  // four planes of floats in [0, 1]
+} Pixel_Format;
+
+typedef struct {
+    unsigned char* memory;
+    Pixel_Format format;
+    bool tiled;         // tiles of SURFACE_TILE_SIZE squared pixels one after the other, row of tiles by row of tiles
+    bool owns_memory;
+    int width;
+    int height;
+    size_t pitch;       // bytes from a row to the next, or from a row of tiles to the next when tiled
+    size_t plane_size;  // bytes from a plane to the next
+} Surface;
+
+Surface make_surface(int width, int height, Pixel_Format format, bool tiled);
+void surface_free(Surface* surface);
+// the canvas pixels seen as a rgb8 surface, nothing is copied
+Surface surface_from_canvas(Canvas canvas);
+
+int pixel_format_size(Pixel_Format format);  // bytes per pixel in one plane
+int pixel_format_planes(Pixel_Format format);
+unsigned char* surface_pixel(const Surface* surface, int x, int y, int plane);
+
+// any format and layout to any other, the sizes have to match
+bool surface_convert(Surface* dst, const Surface* src);
+
+// bulk versions of color_to_rgb and color_to_rgba
+void colors_to_rgb(rgb_t* dst, const Color* src, int count);
+void colors_to_rgba(rgba_t* dst, const Color* src, int count);
+
+#ifdef SURFACE_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(SURFACE_NO_SIMD)
+#define SURFACE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+int pixel_format_size(Pixel_Format format) {
+    return format == PIXEL_RGB8 ? 3 : 4;
+}
+
+int pixel_format_planes(Pixel_Format format) {
+    return format == PIXEL_RGBA_F32_PLANAR ? 4 : 1;
+}
+
+static size_t surface_tile_bytes(Pixel_Format format) {
+    return (size_t)SURFACE_TILE_SIZE * SURFACE_TILE_SIZE * pixel_format_size(format);
+}
+
+Surface make_surface(int width, int height, Pixel_Format format, bool tiled) {
+    Surface surface = {.format = format, .tiled = tiled, .owns_memory = true, .width = width, .height = height};
+    size_t rows = height;
+    if (tiled) {
+        int tiles_x = (width + SURFACE_TILE_SIZE - 1) / SURFACE_TILE_SIZE;
+        surface.pitch = tiles_x * surface_tile_bytes(format);  // tiles are 768 or 1024 bytes, whole cache lines
+        rows = (height + SURFACE_TILE_SIZE - 1) / SURFACE_TILE_SIZE;
+    }
+    else {
+        surface.pitch = ((size_t)width * pixel_format_size(format) + 63) & ~(size_t)63;
+    }
+    surface.plane_size = surface.pitch * rows;
+
+    size_t size = surface.plane_size * pixel_format_planes(format);
+    surface.memory = (unsigned char*)aligned_alloc(64, size ? size : 64);
+    if (!surface.memory) panic("Memory allocation failure");
+    return surface;
+}
+
+void surface_free(Surface* surface) {
+    if (surface->owns_memory) free(surface->memory);
+    memset(surface, 0, sizeof(*surface));
+}
+
+Surface surface_from_canvas(Canvas canvas) {
+    return (Surface){
+        .memory = (unsigned char*)canvas.canvas,
+        .format = PIXEL_RGB8,
+        .width = canvas.width,
+        .height = canvas.height,
+        .pitch = (size_t)canvas.width * sizeof(rgb_t),
+        .plane_size = (size_t)canvas.width * canvas.height * sizeof(rgb_t),
+    };
+}
+
+// byte offset of a pixel in its plane and how many pixels from there on are contiguous in the same row
+static size_t surface_offset(const Surface* surface, int x, int y, int* run) {
+    int size = pixel_format_size(surface->format);
+    if (!surface->tiled) {
+        *run = surface->width - x;
+        return (size_t)y * surface->pitch + (size_t)x * size;
+    }
+
+    int tx = x / SURFACE_TILE_SIZE, ix = x % SURFACE_TILE_SIZE;
+    int ty = y / SURFACE_TILE_SIZE, iy = y % SURFACE_TILE_SIZE;
+    *run = SURFACE_TILE_SIZE - ix;
+    if (*run > surface->width - x) *run = surface->width - x;
+    return (size_t)ty * surface->pitch + tx * surface_tile_bytes(surface->format) + (size_t)(iy * SURFACE_TILE_SIZE + ix) * size;
+}
+
+unsigned char* surface_pixel(const Surface* surface, int x, int y, int plane) {
+    int run;
+    return surface->memory + plane * surface->plane_size + surface_offset(surface, x, y, &run);
+}
+
+// a run of pixels, planes is only used by the planar format
+typedef struct {
+    unsigned char* bytes;
+    float* planes[4];
+} Surface_Run;
+
+typedef void (*Surface_Kernel)(Surface_Run dst, Surface_Run src, int count);
+
+static unsigned char surface_to_byte(float v) {
+    v = v * 255.0f + 0.5f;
+    v = v < 0 ? 0 : v > 255 ? 255 : v;
+    return (unsigned char)(int)v;
+}
+
+static void surface_copy_bytes(Surface_Run dst, Surface_Run src, int count, int size) {
+    memcpy(dst.bytes, src.bytes, (size_t)count * size);
+}
+
+static void surface_rgb8_to_rgb8(Surface_Run dst, Surface_Run src, int count) {
+    surface_copy_bytes(dst, src, count, 3);
+}
+
+static void surface_rgba8_to_rgba8(Surface_Run dst, Surface_Run src, int count) {
+    surface_copy_bytes(dst, src, count, 4);
+}
+
+static void surface_float_to_float(Surface_Run dst, Surface_Run src, int count) {
+    for (int c = 0; c < 4; c++) {
+        memcpy(dst.planes[c], src.planes[c], (size_t)count * sizeof(float));
+    }
+}
+
+static void surface_rgb8_to_rgba8_scalar(Surface_Run dst, Surface_Run src, int count) {
+    for (int i = 0; i < count; i++) {
+        dst.bytes[i * 4] = src.bytes[i * 3];
+        dst.bytes[i * 4 + 1] = src.bytes[i * 3 + 1];
+        dst.bytes[i * 4 + 2] = src.bytes[i * 3 + 2];
+        dst.bytes[i * 4 + 3] = 255;
+    }
+}
+
+static void surface_rgba8_to_rgb8_scalar(Surface_Run dst, Surface_Run src, int count) {
+    for (int i = 0; i < count; i++) {
+        dst.bytes[i * 3] = src.bytes[i * 4];
+        dst.bytes[i * 3 + 1] = src.bytes[i * 4 + 1];
+        dst.bytes[i * 3 + 2] = src.bytes[i * 4 + 2];
+    }
+}
+
+static void surface_bytes_to_float(Surface_Run dst, const unsigned char* src, int size, int count) {
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < 3; c++) {
+            dst.planes[c][i] = src[i * size + c] * (1.0f / 255.0f);
+        }
+        dst.planes[3][i] = size == 4 ? src[i * size + 3] * (1.0f / 255.0f) : 1.0f;
+    }
+}
+
+static void surface_float_to_bytes(unsigned char* dst, int size, Surface_Run src, int count) {
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < size; c++) {
+            dst[i * size + c] = surface_to_byte(src.planes[c][i]);
+        }
+    }
+}
+
+static void surface_rgb8_to_float_scalar(Surface_Run dst, Surface_Run src, int count) {
+    surface_bytes_to_float(dst, src.bytes, 3, count);
+}
+
+static void surface_rgba8_to_float_scalar(Surface_Run dst, Surface_Run src, int count) {
+    surface_bytes_to_float(dst, src.bytes, 4, count);
+}
+
+static void surface_float_to_rgb8_scalar(Surface_Run dst, Surface_Run src, int count) {
+    surface_float_to_bytes(dst.bytes, 3, src, count);
+}
+
+static void surface_float_to_rgba8_scalar(Surface_Run dst, Surface_Run src, int count) {
+    surface_float_to_bytes(dst.bytes, 4, src, count);
+}
+
+#ifdef SURFACE_SIMD_X86
+
+// 12 bytes of rgb are moved as 8 + 4 so nothing outside the run is read or written
+// the kernels clear the upper halves before their scalar tails, sse code after avx2 stalls otherwise
+#define SURFACE_EXPAND_MASK 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+#define SURFACE_PACK_MASK 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+
+__attribute__((target("avx2")))
+static __m256i surface_load_rgb8x8(const unsigned char* p) {
+    int32_t low, high;
+    memcpy(&low, p + 8, 4);
+    memcpy(&high, p + 20, 4);
+    __m128i a = _mm_insert_epi32(_mm_loadl_epi64((const __m128i*)p), low, 2);
+    __m128i b = _mm_insert_epi32(_mm_loadl_epi64((const __m128i*)(p + 12)), high, 2);
+    __m256i expand = _mm256_setr_epi8(SURFACE_EXPAND_MASK, SURFACE_EXPAND_MASK);
+    return _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1), expand);
+}
+
+__attribute__((target("avx2")))
+static void surface_store_rgb8x8(unsigned char* p, __m256i rgba) {
+    __m256i pack = _mm256_setr_epi8(SURFACE_PACK_MASK, SURFACE_PACK_MASK);
+    __m256i packed = _mm256_shuffle_epi8(rgba, pack);
+    __m128i a = _mm256_castsi256_si128(packed), b = _mm256_extracti128_si256(packed, 1);
+    int32_t low = _mm_extract_epi32(a, 2), high = _mm_extract_epi32(b, 2);
+    _mm_storel_epi64((__m128i*)p, a);
+    memcpy(p + 8, &low, 4);
+    _mm_storel_epi64((__m128i*)(p + 12), b);
+    memcpy(p + 20, &high, 4);
+}
+
+__attribute__((target("avx2")))
+static void surface_rgb8_to_rgba8_avx2(Surface_Run dst, Surface_Run src, int count) {
+    const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i rgba = _mm256_or_si256(surface_load_rgb8x8(src.bytes + i * 3), alpha);
+        _mm256_storeu_si256((__m256i*)(dst.bytes + i * 4), rgba);
+    }
+    _mm256_zeroupper();
+    dst.bytes += i * 4;
+    src.bytes += i * 3;
+    surface_rgb8_to_rgba8_scalar(dst, src, count - i);
+}
+
+__attribute__((target("avx2")))
+static void surface_rgba8_to_rgb8_avx2(Surface_Run dst, Surface_Run src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        surface_store_rgb8x8(dst.bytes + i * 3, _mm256_loadu_si256((const __m256i*)(src.bytes + i * 4)));
+    }
+    _mm256_zeroupper();
+    dst.bytes += i * 3;
+    src.bytes += i * 4;
+    surface_rgba8_to_rgb8_scalar(dst, src, count - i);
+}
+
+__attribute__((target("avx2")))
+static void surface_rgba_to_planes(Surface_Run dst, int i, __m256i rgba, bool alpha) {
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+    for (int c = 0; c < 3; c++) {
+        __m256i v = _mm256_and_si256(_mm256_srli_epi32(rgba, 8 * c), byte);
+        _mm256_storeu_ps(dst.planes[c] + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    __m256 a = alpha ? _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(rgba, 24)), scale) : _mm256_set1_ps(1.0f);
+    _mm256_storeu_ps(dst.planes[3] + i, a);
+}
+
+__attribute__((target("avx2")))
+static __m256i surface_planes_to_rgba(Surface_Run src, int i) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(255);
+    const __m256 scale = _mm256_set1_ps(255);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256i rgba = _mm256_setzero_si256();
+    for (int c = 0; c < 4; c++) {
+        // same operations as surface_to_byte
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src.planes[c] + i), scale), half);
+        __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(v, zero), max));
+        rgba = _mm256_or_si256(rgba, _mm256_slli_epi32(b, 8 * c));
+    }
+    return rgba;
+}
+
+__attribute__((target("avx2")))
+static void surface_rgb8_to_float_avx2(Surface_Run dst, Surface_Run src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        surface_rgba_to_planes(dst, i, surface_load_rgb8x8(src.bytes + i * 3), false);
+    }
+    _mm256_zeroupper();
+    for (int c = 0; c < 4; c++) dst.planes[c] += i;
+    surface_bytes_to_float(dst, src.bytes + i * 3, 3, count - i);
+}
+
+__attribute__((target("avx2")))
+static void surface_rgba8_to_float_avx2(Surface_Run dst, Surface_Run src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        surface_rgba_to_planes(dst, i, _mm256_loadu_si256((const __m256i*)(src.bytes + i * 4)), true);
+    }
+    _mm256_zeroupper();
+    for (int c = 0; c < 4; c++) dst.planes[c] += i;
+    surface_bytes_to_float(dst, src.bytes + i * 4, 4, count - i);
+}
+
+__attribute__((target("avx2")))
+static void surface_float_to_rgb8_avx2(Surface_Run dst, Surface_Run src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        surface_store_rgb8x8(dst.bytes + i * 3, surface_planes_to_rgba(src, i));
+    }
+    _mm256_zeroupper();
+    for (int c = 0; c < 4; c++) src.planes[c] += i;
+    surface_float_to_bytes(dst.bytes + i * 3, 3, src, count - i);
+}
+
+__attribute__((target("avx2")))
+static void surface_float_to_rgba8_avx2(Surface_Run dst, Surface_Run src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(dst.bytes + i * 4), surface_planes_to_rgba(src, i));
+    }
+    _mm256_zeroupper();
+    for (int c = 0; c < 4; c++) src.planes[c] += i;
+    surface_float_to_bytes(dst.bytes + i * 4, 4, src, count - i);
+}
+
+#undef SURFACE_EXPAND_MASK
+#undef SURFACE_PACK_MASK
+
+#endif  // SURFACE_SIMD_X86
+
+// [source format][destination format]
+static Surface_Kernel surface_kernels[3][3];
+
+static void surface_pick_kernels(void) {
+    if (__atomic_load_n(&surface_kernels[0][0], __ATOMIC_ACQUIRE)) return;
+
+    Surface_Kernel kernels[3][3] = {
+        {surface_rgb8_to_rgb8, surface_rgb8_to_rgba8_scalar, surface_rgb8_to_float_scalar},
+        {surface_rgba8_to_rgb8_scalar, surface_rgba8_to_rgba8, surface_rgba8_to_float_scalar},
+        {surface_float_to_rgb8_scalar, surface_float_to_rgba8_scalar, surface_float_to_float},
+    };
+#ifdef SURFACE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels[PIXEL_RGB8][PIXEL_RGBA8] = surface_rgb8_to_rgba8_avx2;
+        kernels[PIXEL_RGB8][PIXEL_RGBA_F32_PLANAR] = surface_rgb8_to_float_avx2;
+        kernels[PIXEL_RGBA8][PIXEL_RGB8] = surface_rgba8_to_rgb8_avx2;
+        kernels[PIXEL_RGBA8][PIXEL_RGBA_F32_PLANAR] = surface_rgba8_to_float_avx2;
+        kernels[PIXEL_RGBA_F32_PLANAR][PIXEL_RGB8] = surface_float_to_rgb8_avx2;
+        kernels[PIXEL_RGBA_F32_PLANAR][PIXEL_RGBA8] = surface_float_to_rgba8_avx2;
+    }
+#endif  // SURFACE_SIMD_X86
+
+    for (int s = 0; s < 3; s++) {
+        for (int d = 0; d < 3; d++) {
+            if (s || d) surface_kernels[s][d] = kernels[s][d];
+        }
+    }
+    __atomic_store_n(&surface_kernels[0][0], kernels[0][0], __ATOMIC_RELEASE);
+}
+
+static Surface_Run surface_run(const Surface* surface, size_t offset) {
+    Surface_Run run = {.bytes = surface->memory + offset};
+    if (surface->format == PIXEL_RGBA_F32_PLANAR) {
+        for (int c = 0; c < 4; c++) {
+            run.planes[c] = (float*)(surface->memory + c * surface->plane_size + offset);
+        }
+    }
+    return run;
+}
+
+bool surface_convert(Surface* dst, const Surface* src) {
+    if (dst->width != src->width || dst->height != src->height) {
+        fprintf(stderr, "Cannot convert a %dx%d surface into a %dx%d one\n", src->width, src->height, dst->width, dst->height);
+        return false;
+    }
+    surface_pick_kernels();
+    Surface_Kernel kernel = surface_kernels[src->format][dst->format];
+
+    // whole rows when both are linear, otherwise tile by tile so the tiled side is walked in memory order
+    int block_width = src->width, block_height = 1;
+    if (src->tiled || dst->tiled) {
+        block_width = SURFACE_TILE_SIZE;
+        block_height = SURFACE_TILE_SIZE;
+    }
+
+    for (int y0 = 0; y0 < src->height; y0 += block_height) {
+        int y1 = y0 + block_height < src->height ? y0 + block_height : src->height;
+        for (int x = 0; x < src->width; x += block_width) {
+            for (int y = y0; y < y1; y++) {
+                int src_run, dst_run;
+                size_t src_offset = surface_offset(src, x, y, &src_run);
+                size_t dst_offset = surface_offset(dst, x, y, &dst_run);
+                kernel(surface_run(dst, dst_offset), surface_run(src, src_offset), src_run < dst_run ? src_run : dst_run);
+            }
+        }
+    }
+    return true;
+}
+
+// Color has the layout of rgba_t
+void colors_to_rgb(rgb_t* dst, const Color* src, int count) {
+    surface_pick_kernels();
+    surface_kernels[PIXEL_RGBA8][PIXEL_RGB8]((Surface_Run){.bytes = (unsigned char*)dst}, (Surface_Run){.bytes = (unsigned char*)src}, count);
+}
+
+void colors_to_rgba(rgba_t* dst, const Color* src, int count) {
+    memcpy(dst, src, (size_t)count * sizeof(rgba_t));
+}
+
+#endif // SURFACE_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _SURFACE
@@ -0,0 +1,86 @@
+// string precision in asynchronous mode, the arguments are not terminated so only the precision may be read
+// cc -g -fsanitize=address -I.. -o log_test log_test.c -lpthread -lm && ./log_test
+
+#define LOG_IMPLEMENTATION
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char* text_path = "log_test.txt";
+static const char* binary_path = "log_test.bin";
+static const char* decoded_path = "log_test.decoded.txt";
+
+static const char* expected =
+    "[INFO]: view hello end\n"
+    "[INFO]: view hel end\n"
+    "[INFO]: view [  he] end\n"
+    "[INFO]: view  end\n"
+    "[INFO]: view he end\n";
+
+// a heap buffer exactly as long as the text, without the terminator
+static char* make_unterminated(const char* text) {
+    size_t size = strlen(text);
+    char* data = malloc(size);
+    memcpy(data, text, size);
+    return data;
+}
+
+// not a literal, the call is formatted on the spot
+static const char* runtime_format = "view %.2s end";
+
+static void log_messages(const char* data, int size) {
+    LOG_INFOF("view %.*s end", size, data);
+    LOG_INFOF("view %.3s end", data);
+    LOG_INFOF("view [%*.*s] end", 4, 2, data);
+    LOG_INFOF("view %.0s end", data);
+    LOG_INFOF(runtime_format, data);
+}
+
+static bool check_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Could not open file %s\n", path);
+        return false;
+    }
+    char buffer[1024];
+    size_t size = fread(buffer, 1, sizeof(buffer) - 1, file);
+    buffer[size] = '\0';
+    fclose(file);
+
+    if (strcmp(buffer, expected) != 0) {
+        fprintf(stderr, "%s has\n%s\ninstead of\n%s\n", path, buffer, expected);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    char* data = make_unterminated("hello");
+    bool ok = true;
+
+    remove(text_path);
+    log_file_open((Log_File_Config){.path = text_path});
+    log_async_start((Log_Async_Config){0});
+    log_messages(data, 5);
+    log_async_stop();
+    log_file_close();
+    ok &= check_file(text_path);
+
+    log_async_start((Log_Async_Config){.binary_path = binary_path});
+    log_messages(data, 5);
+    log_async_stop();
+    FILE* in = fopen(binary_path, "rb");
+    FILE* out = fopen(decoded_path, "w");
+    ok &= in && out && log_decode(in, out);
+    if (in) fclose(in);
+    if (out) fclose(out);
+    ok &= check_file(decoded_path);
+
+    free(data);
+    remove(text_path);
+    remove(binary_path);
+    remove(decoded_path);
+    printf(ok ? "ok\n" : "failed\n");
+    return ok ? 0 : 1;
+}
@@ -1,19 +1,47 @@
 #ifndef _UTILITY_H
 #define _UTILITY_H
 
+// strict iso modes (-std=c11) hide posix, which the implementations need (mmap hints, clocks, O_CLOEXEC, ...)
+// and the system extensions, madvise with MADV_HUGEPAGE is one (glibc's _DEFAULT_SOURCE)
+// it only takes effect when this header comes before any system header
+#if defined(UTILITY_IMPLEMENTATION) && defined(__STRICT_ANSI__)
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#endif
+
 #include <stdint.h>
 #include <stdlib.h>
 
 
 #ifdef UTILITY_IMPLEMENTATION  // if implementation is defined than define the implementation for the other ones as well
 
+#define ARENA_IMPLEMENTATION
 #define STRING_BUILDER_IMPLEMENTATION
+#define HASH_IMPLEMENTATION
+#define HASH_MAP_IMPLEMENTATION
+#define INTERN_IMPLEMENTATION
+#define LINE_READER_IMPLEMENTATION
 #define LINEAR_MATH_IMPLEMENTATION
 #define LOG_IMPLEMENTATION
+#define IMAGE_IMPLEMENTATION  // image.h is not included here, it includes this header
+#define RASTER_IMPLEMENTATION  // same for raster.h
+#define RENDER_IMPLEMENTATION  // and render.h
+#define SURFACE_IMPLEMENTATION  // and surface.h
+#define FRAME_STREAM_IMPLEMENTATION  // and frame_stream.h
+#define FAST_MATH_IMPLEMENTATION  // and fast_math.h
 
 #endif // UTILITY_IMPLEMENTATION
 
+#include "arena.h"
 #include "string_builder.h"
+#include "hash.h"
+#include "hash_map.h"
+#include "intern.h"
+#include "line_reader.h"
 #include "log.h"
 #include "linear_math.h"
 
@@ -77,7 +105,7 @@ uint64_t next_multiple_of_wordsize(uint64_t n);
 char* number_to_string(double number, int precision /* after decimal point */);
 unsigned int cstring_to_integer(char* s);
 
-int hash_string(const String* string);
+int hash_string(const String* string);  // hash_string64 with a zero seed folded into an int
 const char* ordinal_string(int n);
 bool compare_string(String, String);
 
@@ -102,6 +130,7 @@ typedef struct {
 } Canvas;
 
 Canvas make_canvas(int width, int height);
+Canvas make_canvas_arena(Arena* arena, int width, int height);
 
 bool output_ppm(char* file_name, Canvas canvas);
 
@@ -119,13 +148,59 @@ typedef struct {
 long file_len(FILE* handle);
 File load_file(const char* path);
 
+// loads many files on a pool of threads, all the contents (each null terminated) share the allocation of the File array
+// failures are reported through the error_code of each File instead of stderr
+File_List load_files(const char** paths, int count, int thread_count /* 0 picks one based on the core count */);
+void file_list_free(File_List* list);
+
+// read only memory mapping of a whole file, the bytes can be used as String views without copying
+typedef enum {
+    MAP_ADVICE_NONE       = 0,
+    MAP_ADVICE_SEQUENTIAL = BIT(0),  // aggressive read ahead, pages behind the reader can be dropped early
+    MAP_ADVICE_WILLNEED   = BIT(1),  // start reading the whole file in now
+    MAP_ADVICE_HUGEPAGE   = BIT(2),  // back the mapping with huge pages where the kernel supports it for files
+                                     // ignored if MADV_HUGEPAGE was hidden, see the top of the file
+} Map_Advice;
+
+typedef struct {
+    const char* data;
+    size_t size;
+    int error_code;  // 0 if no errors
+} Mapped_File;
+
+Mapped_File map_file(const char* path, int advice /* Map_Advice flags */);
+void unmap_file(Mapped_File* file);
+// String sizes are ints, so files over 2GB are handed out in chunks (e.g. to feed a String_Split_Iterator)
+String mapped_file_chunk(Mapped_File file, size_t offset, int max_size);
+
 String file_extension(const char* path);
 
 #ifdef UTILITY_IMPLEMENTATION
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// canvases start on a cache line so tiles rendered by different threads do not share one (see render.h)
 Canvas make_canvas(int width, int height) {
     Canvas canvas;
-    rgb_t* mem = malloc(width * height * sizeof(rgb_t));
+    size_t size = ((size_t)width * height * sizeof(rgb_t) + 63) & ~(size_t)63;
+    rgb_t* mem = aligned_alloc(64, size ? size : 64);
+    if (!mem) panic("Memory allocation failure");
+
+    canvas.canvas = mem;
+    canvas.width = width;
+    canvas.height = height;
+
+    return canvas;
+}
+
+Canvas make_canvas_arena(Arena* arena, int width, int height) {
+    Canvas canvas;
+    rgb_t* mem = (rgb_t*)arena_push_aligned(arena, (size_t)width * height * sizeof(rgb_t), 64);
     if (!mem) panic("Memory allocation failure");
 
     canvas.canvas = mem;
@@ -136,7 +211,7 @@ Canvas make_canvas(int width, int height) {
 }
 
 bool output_ppm(char* file_name, Canvas canvas) {
-    FILE* output = fopen(file_name, "w");
+    FILE* output = fopen(file_name, "wb");
     if (!output) {
         return false;
     }
@@ -146,14 +221,12 @@ bool output_ppm(char* file_name, Canvas canvas) {
     const int max_color_value = 255;
     fprintf(output, "%s %d %d %d\n", magic, canvas.width, canvas.height, max_color_value);
 
-    int size = canvas.width * canvas.height;
-    for (int i = 0; i < size; i++) {
-        rgb_t rgb = canvas.canvas[i];
-        fprintf(output, "%c%c%c", rgb.r, rgb.g, rgb.b);
-    }
+    // rgb_t is three packed bytes, so the canvas already is the P6 pixel data and goes out in one write
+    size_t size = (size_t)canvas.width * canvas.height;
+    bool ok = fwrite(canvas.canvas, sizeof(rgb_t), size, output) == size;
 
-    fclose(output);
-    return true;
+    if (fclose(output) != 0) ok = false;
+    return ok;
 }
 
 [[noreturn]]
@@ -179,14 +252,14 @@ long file_len(FILE* handle) {
     long curr = ftell(handle);
     fseek(handle, 0, SEEK_END);
     long size = ftell(handle);
-    fseek(handle, 0, curr);
+    fseek(handle, curr, SEEK_SET);
     return size;
 }
 
 File load_file(const char* path) {
     File file;
 
-    FILE* handle = fopen(path, "r");
+    FILE* handle = fopen(path, "rb");
     if (!handle) {
         fprintf(stderr, "Could not open file %s\n", path);
         file.error_code = 1;
@@ -197,6 +270,9 @@ File load_file(const char* path) {
     char* data = (char*) malloc(file_size);
     if (!data) {
       fprintf(stderr, "Memory allocation failure trying to load the file %s\n", path);
+      fclose(handle);
+      file.error_code = 1;
+      return file;
     }
     long read = fread(data, 1, file_size, handle);
     if (read != file_size) {
@@ -212,6 +288,188 @@ File load_file(const char* path) {
     return file;
 }
 
+typedef struct {
+    const char** paths;
+    File* files;
+    size_t* sizes;
+    char* contents;
+    size_t* offsets;
+    int count;
+    int next;  // next path to be claimed by a worker
+    int phase;
+} Load_Files_Job;
+
+static void load_files_stat(Load_Files_Job* job, int i) {
+    struct stat st;
+    if (stat(job->paths[i], &st) != 0 || !S_ISREG(st.st_mode)) {
+        job->sizes[i] = 0;
+        job->files[i].error_code = 1;
+        return;
+    }
+    job->sizes[i] = (size_t)st.st_size;
+    job->files[i].error_code = 0;
+}
+
+static void load_files_read(Load_Files_Job* job, int i) {
+    File* file = &job->files[i];
+    file->data = job->contents + job->offsets[i];
+    file->size = 0;
+    file->data[0] = '\0';
+    if (file->error_code) return;
+
+    int fd = open(job->paths[i], O_RDONLY);
+    if (fd < 0) {
+        file->error_code = 1;
+        return;
+    }
+
+    // reads at most the size seen by stat, in case the file grew in the meantime
+    size_t size = job->sizes[i];
+    while (file->size < size) {
+        ssize_t n = read(fd, file->data + file->size, size - file->size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) file->error_code = 1;
+        if (n <= 0) break;
+        file->size += (size_t)n;
+    }
+    file->data[file->size] = '\0';
+    close(fd);
+}
+
+static void* load_files_worker(void* arg) {
+    Load_Files_Job* job = (Load_Files_Job*)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (i >= job->count) break;
+        if (job->phase == 0) load_files_stat(job, i);
+        else load_files_read(job, i);
+    }
+    return NULL;
+}
+
+static void load_files_run(Load_Files_Job* job, int phase, int thread_count) {
+    job->phase = phase;
+    job->next = 0;
+
+    pthread_t threads[64];
+    int started = 0;
+    for (; started < thread_count - 1; started++) {
+        if (pthread_create(&threads[started], NULL, load_files_worker, job) != 0) break;
+    }
+    load_files_worker(job);  // the calling thread works too, and does everything if no thread could be started
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+File_List load_files(const char** paths, int count, int thread_count) {
+    File_List list = (File_List){.data = NULL, .size = 0};
+    if (count <= 0) return list;
+
+    if (thread_count <= 0) {
+        // the work is bound by i/o latency rather than cpu, so oversubscribe
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (int)(cores > 0 ? cores * 4 : 4);
+    }
+    thread_count = CLAMP(thread_count, 1, 64);
+    if (thread_count > count) thread_count = count;
+
+    Load_Files_Job job = (Load_Files_Job){.paths = paths, .count = count};
+    job.sizes = (size_t*)malloc(count * 2 * sizeof(size_t));
+    File* stats = (File*)malloc(count * sizeof(File));
+    if (!job.sizes || !stats) panic("Memory allocation failure");
+    job.offsets = job.sizes + count;
+    job.files = stats;
+
+    load_files_run(&job, 0, thread_count);
+
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        job.offsets[i] = total;
+        total += job.sizes[i] + 1;
+    }
+
+    size_t header = next_multiple_of_wordsize(count * sizeof(File));
+    char* mem = (char*)malloc(header + total);
+    if (!mem) panic("Memory allocation failure");
+
+    job.files = (File*)mem;
+    job.contents = mem + header;
+    for (int i = 0; i < count; i++) {
+        job.files[i].error_code = stats[i].error_code;
+    }
+    free(stats);
+
+    load_files_run(&job, 1, thread_count);
+    free(job.sizes);
+
+    list.data = job.files;
+    list.size = count;
+    return list;
+}
+
+void file_list_free(File_List* list) {
+    free(list->data);  // the contents live in the same allocation
+    list->data = NULL;
+    list->size = 0;
+}
+
+Mapped_File map_file(const char* path, int advice) {
+    Mapped_File file = (Mapped_File){.data = NULL, .size = 0, .error_code = 0};
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open file %s\n", path);
+        file.error_code = 1;
+        return file;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Could not stat file %s\n", path);
+        close(fd);
+        file.error_code = 1;
+        return file;
+    }
+
+    // an empty mapping is not allowed, empty files come back as a NULL view
+    if (st.st_size == 0) {
+        close(fd);
+        return file;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps its own reference to the file
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map file %s\n", path);
+        file.error_code = 1;
+        return file;
+    }
+
+    if (advice & MAP_ADVICE_SEQUENTIAL) posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    if (advice & MAP_ADVICE_WILLNEED) posix_madvise(data, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (advice & MAP_ADVICE_HUGEPAGE) madvise(data, (size_t)st.st_size, MADV_HUGEPAGE);
+#endif
+
+    file.data = (const char*)data;
+    file.size = (size_t)st.st_size;
+    return file;
+}
+
+void unmap_file(Mapped_File* file) {
+    if (file->data) munmap((void*)file->data, file->size);
+    file->data = NULL;
+    file->size = 0;
+}
+
+String mapped_file_chunk(Mapped_File file, size_t offset, int max_size) {
+    if (offset >= file.size) return (String){.data = file.data + file.size, .size = 0};
+    size_t remaining = file.size - offset;
+    int size = remaining < (size_t)max_size ? (int)remaining : max_size;
+    return (String){.data = file.data + offset, .size = size};
+}
+
 char* number_to_string(double number, int precision /* after decimal point */) {
   // decimal
 
@@ -278,16 +536,8 @@ unsigned int cstring_to_integer(char* s) {
 }
 
 int hash_string(const String* string) {
-    int result = 0;
-    int pow = 1;
-
-    for (int i = string->size - 1; i > 0; i--, pow *= 31) {
-        result += string->data[i] * pow;
-    }
-
-    result += string->data[0] * pow;
-
-    return result;
+    uint64_t h = hash_string64(*string, 0);
+    return (int)(h ^ (h >> 32));
 }
 
 const char* ordinal_string(int n) {
@@ -321,7 +571,7 @@ float rand_float() {
 }
 
 float lerp(float s, float e, float t) {
-    return (1-t)*s + t*s;
+    return (1-t)*s + t*e;
 }
 
 float smoothstep(float x) {